@@ -0,0 +1,348 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/********************************************//**
+ * \brief Performance measurements of panel hot paths.
+ *
+ * Every benchmark runs previous implementation (replicated
+ * here) and current one on the same data and prints both
+ * times. It doesn't need database server, but it should be
+ * started from directory with panel files (like panel.wt).
+ *
+ * Build with cmake -DBUILD_BENCHMARKS=ON.
+ *
+ ***********************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <malloc.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <Wt/WApplication>
+#include <Wt/WString>
+#include <Wt/WText>
+#include <Wt/Test/WTestEnvironment>
+
+#include "compiledTemplate.h"
+#include "config.h"
+#include "database.h"
+#include "messageStore.h"
+
+#define BENCH_DECODE_ROWS       10000
+#define BENCH_DECODE_FIELDS     100     // 1M cells
+#define BENCH_SESSIONS          1000
+#define BENCH_RENDERS           10000
+#define BENCH_TEMPLATE_FILE     "res/templates/default/default.tmplt"
+#define BENCH_MESSAGES_PATH     "langs/panel"
+#define BENCH_MESSAGES_LOCALE   "pl"
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double ElapsedMs(BenchClock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// bytes allocated by malloc (and new) at the moment
+static long HeapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+}
+
+static void PrintResult(const char * name, double before, double after, const char * unit)
+{
+    printf("%-40s before: %10.3f %s  after: %10.3f %s  (x%.1f)\n", name, before, unit, after, unit, after > 0.0 ? before / after : 0.0);
+}
+
+/********************************************//**
+ * \brief Numeric field decode cost per million cells.
+ *
+ * Previously every cell was kept as WString and each
+ * GetUInt32() converted it to UTF8 std::string and
+ * parsed it with sscanf.
+ *
+ ***********************************************/
+
+static void BenchFieldDecode()
+{
+    std::vector<std::string> values;
+    values.reserve(BENCH_DECODE_ROWS * BENCH_DECODE_FIELDS);
+
+    for (uint32 i = 0; i < BENCH_DECODE_ROWS * BENCH_DECODE_FIELDS; ++i)
+        values.push_back(std::to_string((i * 7919u) % 4000000000u));
+
+    DatabaseResult result;
+    result.Reserve(BENCH_DECODE_ROWS, BENCH_DECODE_FIELDS);
+
+    std::vector<char*> row(BENCH_DECODE_FIELDS);
+    for (uint32 r = 0; r < BENCH_DECODE_ROWS; ++r)
+    {
+        for (uint32 f = 0; f < BENCH_DECODE_FIELDS; ++f)
+            row[f] = const_cast<char*>(values[r * BENCH_DECODE_FIELDS + f].c_str());
+
+        result.AddRow(&row[0], BENCH_DECODE_FIELDS);
+    }
+
+    std::vector<Wt::WString> oldValues;
+    oldValues.reserve(values.size());
+
+    for (std::vector<std::string>::const_iterator itr = values.begin(); itr != values.end(); ++itr)
+        oldValues.push_back(Wt::WString::fromUTF8(*itr));
+
+    uint64 oldSum = 0;
+    BenchClock::time_point start = BenchClock::now();
+
+    for (std::vector<Wt::WString>::const_iterator itr = oldValues.begin(); itr != oldValues.end(); ++itr)
+    {
+        uint32 tmp = 0;
+        sscanf(itr->toUTF8().c_str(), "%u", &tmp);
+        oldSum += tmp;
+    }
+
+    double before = ElapsedMs(start);
+
+    uint64 newSum = 0;
+    start = BenchClock::now();
+
+    const std::vector<DatabaseRow> & rows = result.GetRows();
+    for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+        for (int f = 0; f < itr->count; ++f)
+            newSum += itr->fields[f].GetUInt32();
+
+    double after = ElapsedMs(start);
+
+    PrintResult("field decode (1M cells GetUInt32)", before, after, "ms");
+
+    if (oldSum != newSum)
+        printf("    checksum mismatch: %llu != %llu\n", (unsigned long long)oldSum, (unsigned long long)newSum);
+}
+
+// drops everything written to it
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) { return c; }
+};
+
+/********************************************//**
+ * \brief Config cost per session creation.
+ *
+ * Previously CreateApplication called ReadConfig()
+ * for every session, now session only takes current
+ * snapshot and reads options it needs.
+ *
+ ***********************************************/
+
+static void BenchSessionConfig()
+{
+    if (!sConfig.ReadConfig())
+    {
+        printf("session config: config.xml can't be read - skipped\n");
+        return;
+    }
+
+    // ReadConfig prints progress, printing isn't measured
+    NullBuffer nullBuffer;
+    std::streambuf * coutBuffer = std::cout.rdbuf(&nullBuffer);
+
+    BenchClock::time_point start = BenchClock::now();
+
+    for (int i = 0; i < BENCH_SESSIONS; ++i)
+        sConfig.ReadConfig();
+
+    double before = ElapsedMs(start);
+
+    std::cout.rdbuf(coutBuffer);
+
+    size_t length = 0;
+    start = BenchClock::now();
+
+    for (int i = 0; i < BENCH_SESSIONS; ++i)
+    {
+        ConfigDataPtr config = sConfig.GetSnapshot();
+
+        length += config->GetConfig(CONFIG_DEFAULT_TEMPLATE_NAME).size();
+        length += config->GetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH).size();
+        length += config->GetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH).size();
+        length += config->GetConfig(CONFIG_LANGUAGE_FILE_PATH).size();
+        length += config->GetConfig(CONFIG_OPTIONS_DEBUG) + config->GetConfig(CONFIG_OPTIONS_LOG);
+    }
+
+    double after = ElapsedMs(start);
+
+    PrintResult("session config (per session)", before * 1000.0 / BENCH_SESSIONS, after * 1000.0 / BENCH_SESSIONS, "us");
+
+    if (!length)
+        printf("    empty config\n");
+}
+
+// binds the same widgets, functions and conditions as PlayersPanel
+static void SetupTemplate(Wt::WTemplate * templ)
+{
+    templ->bindWidget("add-langs", new Wt::WText("langs"));
+    templ->bindWidget("add-login", new Wt::WText("login"));
+    templ->bindWidget("add-menu", new Wt::WText("menu"));
+    templ->bindWidget("add-content", new Wt::WText("content"));
+    templ->bindWidget("add-profile", new Wt::WText("profile"));
+    templ->bindWidget("add-templatechooser", new Wt::WText("templates"));
+    templ->bindWidget("add-footer", new Wt::WText("footer"));
+
+    templ->addFunction("tr", &Wt::WTemplate::Functions::tr);
+}
+
+// one login or logout - conditions are switched and template is rendered again
+static void RenderLogins(Wt::WTemplate * templ)
+{
+    for (int i = 0; i < BENCH_RENDERS; ++i)
+    {
+        templ->setCondition("if-loggedin", i % 2 == 0);
+        templ->setCondition("if-notlogged", i % 2 != 0);
+
+        std::ostringstream result;
+        templ->renderTemplate(result);
+    }
+}
+
+/********************************************//**
+ * \brief Template render cost per login.
+ *
+ * Previously WTemplate parsed template text
+ * for placeholders on every render, now
+ * PanelTemplate walks precompiled segments.
+ *
+ ***********************************************/
+
+static void BenchTemplateRender()
+{
+    std::ifstream file(BENCH_TEMPLATE_FILE);
+    if (!file)
+    {
+        printf("template render: %s can't be read - skipped\n", BENCH_TEMPLATE_FILE);
+        return;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+
+    TemplateInfo tmplt;
+    tmplt.currentTemplate = TemplateTextPtr(new std::string(text.str()));
+    tmplt.compiledTemplate = TemplateSegmentsPtr(TemplateSegments::Compile(*tmplt.currentTemplate));
+
+    if (!tmplt.compiledTemplate)
+    {
+        printf("template render: %s can't be compiled - skipped\n", BENCH_TEMPLATE_FILE);
+        return;
+    }
+
+    Wt::Test::WTestEnvironment env;
+    Wt::WApplication app(env);
+
+    Wt::WTemplate * oldTempl = new Wt::WTemplate(app.root());
+    SetupTemplate(oldTempl);
+    oldTempl->setTemplateText(Wt::WString::fromUTF8(*tmplt.currentTemplate), Wt::XHTMLUnsafeText);
+
+    PanelTemplate * newTempl = new PanelTemplate(app.root());
+    SetupTemplate(newTempl);
+    newTempl->SetTemplate(tmplt);
+
+    BenchClock::time_point start = BenchClock::now();
+    RenderLogins(oldTempl);
+    double before = ElapsedMs(start);
+
+    start = BenchClock::now();
+    RenderLogins(newTempl);
+    double after = ElapsedMs(start);
+
+    PrintResult("template render (per login)", before * 1000.0 / BENCH_RENDERS, after * 1000.0 / BENCH_RENDERS, "us");
+}
+
+// resolves key in default and second locale, so session loads both message files
+static size_t ResolveMessages(Wt::WApplication & app)
+{
+    size_t length = Wt::WString::tr(TXT_SITE_TITLE).toUTF8().size();
+
+    app.setLocale(BENCH_MESSAGES_LOCALE);
+    length += Wt::WString::tr(TXT_SITE_TITLE).toUTF8().size();
+
+    return length;
+}
+
+/********************************************//**
+ * \brief Messages memory per session.
+ *
+ * Previously every session used own message resource
+ * bundle with copy of all langs/panel*.xml messages,
+ * now sessions resolve keys in shared MessageStore
+ * which is loaded once.
+ *
+ ***********************************************/
+
+static void BenchSessionMessages()
+{
+    long before, after;
+
+    {
+        Wt::Test::WTestEnvironment env;
+        Wt::WApplication app(env);
+
+        long heap = HeapInUse();
+        app.messageResourceBundle().use(BENCH_MESSAGES_PATH);
+        ResolveMessages(app);
+        before = HeapInUse() - heap;
+    }
+
+    long heap = HeapInUse();
+    if (!sMessageStore.Load(BENCH_MESSAGES_PATH))
+    {
+        printf("session messages: %s.xml can't be loaded - skipped\n", BENCH_MESSAGES_PATH);
+        return;
+    }
+
+    long shared = HeapInUse() - heap;
+
+    {
+        Wt::Test::WTestEnvironment env;
+        Wt::WApplication app(env);
+
+        heap = HeapInUse();
+        app.setLocalizedStrings(new SessionMessages());
+        ResolveMessages(app);
+        after = HeapInUse() - heap;
+    }
+
+    PrintResult("session messages (bytes per session)", double(before), double(after), "B");
+    printf("    shared MessageStore (loaded once): %ld B\n", shared);
+}
+
+int main(int argc, char **argv)
+{
+    BenchFieldDecode();
+    BenchSessionConfig();
+    BenchTemplateRender();
+    BenchSessionMessages();
+
+    return 0;
+}
@@ -38,52 +38,41 @@ void LangsWidget::AddLangButton(Lang lang, const char * txt)
     tmpBtn->clicked().connect(boost::bind(&LangsWidget::ChangeLanguage, this, lang));
 }
 
-void LangsWidget::ChangeLanguage(Lang lang)
+const char * LangsWidget::GetLocaleName(Lang lang)
 {
-    std::string loc;
-
     switch (lang)
     {
         case LANG_PL:
-            loc = "pl";
-            break;
+            return "pl";
         case LANG_EN:
-            loc = "en";
-            break;
+            return "en";
         case LANG_JA:
-            loc = "ja";
-            break;
+            return "ja";
         case LANG_RU:
-            loc = "ru";
-            break;
+            return "ru";
         case LANG_CZ:
-            loc = "cz";
-            break;
+            return "cz";
         case LANG_IT:
-            loc = "it";
-            break;
+            return "it";
         case LANG_DE:
-            loc = "de";
-            break;
+            return "de";
         case LANG_FR:
-            loc = "fr";
-            break;
+            return "fr";
         case LANG_ES:
-            loc = "es";
-            break;
+            return "es";
         case LANG_CS:
-            loc = "cs";
-            break;
+            return "cs";
         case LANG_PT:
-            loc = "pt";
-            break;
+            return "pt";
         case LANG_ZH:
-            loc = "zh";
-            break;
+            return "zh";
         default:
-            loc = "en";
-            break;
+            return "en";
     }
+}
 
-    wApp->setLocale(loc);
+void LangsWidget::ChangeLanguage(Lang lang)
+{
+    // refreshes whole widget tree, pages showing names from MessageStore::GetEnumNames() fill them again in refresh()
+    wApp->setLocale(GetLocaleName(lang));
 }
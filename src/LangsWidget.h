@@ -28,6 +28,8 @@ public:
     LangsWidget(Wt::WContainerWidget * parent = NULL);
     ~LangsWidget() {}
 
+    static const char * GetLocaleName(Lang lang);       /// returns locale name used by Wt (and in langs/panel_<locale>.xml file names)
+
 private:
     void ChangeLanguage(Lang lang);
 
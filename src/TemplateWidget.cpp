@@ -24,18 +24,18 @@
 #include <Wt/WTemplate>
 #include <Wt/WText>
 
-#include "database.h"
+#include "compiledTemplate.h"
 #include "misc.h"
 
-TemplateWidget::TemplateWidget(Wt::WTemplate * templ, Wt::WContainerWidget * parent)
+TemplateWidget::TemplateWidget(PanelTemplate * templ, Wt::WContainerWidget * parent)
 : Wt::WContainerWidget(parent)
 {
     templt = templ;
     templateCombo = new Wt::WComboBox();
 
-    templates = Misc::GetTemplatesFromDB();
+    templates = sTemplateRegistry.GetTemplates();
 
-    for (std::vector<TemplateInfo>::const_iterator itr = templates.begin(); itr != templates.end(); ++itr)
+    for (std::vector<TemplateInfo>::const_iterator itr = templates->templates.begin(); itr != templates->templates.end(); ++itr)
         templateCombo->addItem((*itr).name);
 
     Wt::WPushButton * tmpButton = new Wt::WPushButton();
@@ -53,20 +53,20 @@ TemplateWidget::TemplateWidget(Wt::WTemplate * templ, Wt::WContainerWidget * par
 
 void TemplateWidget::ChangeTemplate()
 {
-    if (!templateCombo->count() || templateCombo->currentIndex() < 0 || templateCombo->currentIndex() > templates.size())
+    if (!templateCombo->count() || templateCombo->currentIndex() < 0 || templateCombo->currentIndex() >= int(templates->templates.size()))
         return;
 
-    TemplateInfo tmpltInfo = templates[templateCombo->currentIndex()];
+    const TemplateInfo & tmpltInfo = templates->templates[templateCombo->currentIndex()];
 
     // it's probably impossible but ...
     if (tmpltInfo.name != templateCombo->currentText())
         return;
 
-    if (tmpltInfo.currentTemplate.empty() || tmpltInfo.stylePath.empty())
+    if (!tmpltInfo.currentTemplate || tmpltInfo.stylePath.empty())
         return;
 
     wApp->useStyleSheet(tmpltInfo.GetFullStylePath());
     wApp->setCookie("tmplt", tmpltInfo.name, WEEK);
-    templt->setTemplateText(tmpltInfo.currentTemplate);
+    templt->SetTemplate(tmpltInfo);
     templt->refresh();
 }
@@ -21,17 +21,20 @@
 #include <Wt/WContainerWidget>
 
 #include "defines.h"
+#include "templateRegistry.h"
+
+class PanelTemplate;
 
 class TemplateWidget : public Wt::WContainerWidget
 {
 public:
-    TemplateWidget(Wt::WTemplate * templ, Wt::WContainerWidget * parent = NULL);
+    TemplateWidget(PanelTemplate * templ, Wt::WContainerWidget * parent = NULL);
     ~TemplateWidget() {}
 
 private:
-    std::vector<TemplateInfo> templates;
+    TemplateListPtr templates;                          /// list shared with other sessions
     Wt::WComboBox * templateCombo;
-    Wt::WTemplate * templt;
+    PanelTemplate * templt;
 
     void ChangeTemplate();
 };
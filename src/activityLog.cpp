@@ -0,0 +1,312 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "activityLog.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <map>
+
+#include "config.h"
+#include "database.h"
+#include "misc.h"
+
+// max rows in one insert - keeps query size reasonable
+#define ACTIVITY_ROWS_PER_INSERT 100
+
+static std::string LowerCase(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+    return str;
+}
+
+ActivityLog::ActivityLog()
+    : stopping(false), written(0), dropped(0), failed(0), loggedDropped(0), loggedFailed(0)
+{
+    maxPending = sConfig.GetConfig(CONFIG_ACTIVITY_QUEUE_SIZE) > 0 ? sConfig.GetConfig(CONFIG_ACTIVITY_QUEUE_SIZE) : 1;
+    flushSize = sConfig.GetConfig(CONFIG_ACTIVITY_FLUSH_SIZE) > 0 ? sConfig.GetConfig(CONFIG_ACTIVITY_FLUSH_SIZE) : 1;
+    flushInterval = sConfig.GetConfig(CONFIG_ACTIVITY_FLUSH_INTERVAL) > 0 ? sConfig.GetConfig(CONFIG_ACTIVITY_FLUSH_INTERVAL) : 1;
+
+    pending.reserve(flushSize);
+
+    writer = std::thread(&ActivityLog::Run, this);
+}
+
+ActivityLog::~ActivityLog()
+{
+    Stop();
+}
+
+ActivityLog & ActivityLog::Instance()
+{
+    // same as in Config::Instance()
+    if (_activityLog == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_activityLog == nullptr)
+            _activityLog = new ActivityLog();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<ActivityLog*>(_activityLog);
+}
+
+void ActivityLog::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(_createMutex);
+
+    if (_activityLog != nullptr)
+        const_cast<ActivityLog*>(_activityLog)->Stop();
+}
+
+void ActivityLog::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        stopping = true;
+    }
+
+    pendingCondition.notify_all();
+
+    // writer flushes buffer before exit
+    if (writer.joinable())
+        writer.join();
+}
+
+void ActivityLog::Add(uint32 accountId, const std::string & ip, const char * activity, const std::string & activityArgs)
+{
+    ActivityEntry entry;
+    entry.accountId = accountId;
+    entry.ip = ip;
+    entry.activity = activity;
+    entry.activityArgs = activityArgs;
+    entry.time = std::time(NULL);
+
+    Add(entry);
+}
+
+void ActivityLog::Add(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs)
+{
+    ActivityEntry entry;
+    entry.username = username;
+    entry.ip = ip;
+    entry.activity = activity;
+    entry.activityArgs = activityArgs;
+    entry.time = std::time(NULL);
+
+    Add(entry);
+}
+
+void ActivityLog::Add(const ActivityEntry & entry)
+{
+    bool flush;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+
+        if (stopping || pending.size() >= maxPending)
+        {
+            ++dropped;
+            return;
+        }
+
+        pending.push_back(entry);
+        flush = pending.size() >= flushSize;
+    }
+
+    if (flush)
+        pendingCondition.notify_one();
+}
+
+void ActivityLog::Run()
+{
+    std::vector<ActivityEntry> entries;
+    entries.reserve(flushSize);
+
+    while (true)
+    {
+        bool stop;
+
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex);
+
+            std::chrono::steady_clock::time_point flushTime = std::chrono::steady_clock::now() + std::chrono::seconds(flushInterval);
+
+            while (!stopping && pending.size() < flushSize)
+                if (pendingCondition.wait_until(lock, flushTime) == std::cv_status::timeout)
+                    break;
+
+            stop = stopping;
+
+            // take whole buffer, pages can fill new one while we are writing
+            entries.swap(pending);
+        }
+
+        if (!entries.empty())
+            Write(entries);
+
+        entries.clear();
+
+        LogLost();
+
+        if (stop)
+            break;
+    }
+}
+
+void ActivityLog::ResolveAccounts(std::vector<ActivityEntry> & entries, Database & db)
+{
+    std::string usernames;
+
+    for (std::vector<ActivityEntry>::const_iterator itr = entries.begin(); itr != entries.end(); ++itr)
+    {
+        if (itr->accountId)
+            continue;
+
+        if (!usernames.empty())
+            usernames += ", ";
+
+        usernames += "'" + db.EscapeString(itr->username) + "'";
+    }
+
+    if (usernames.empty())
+        return;
+
+    std::map<std::string, uint32> accounts;
+
+    if (db.ExecuteQuery("SELECT account_id, username FROM account WHERE username IN (" + usernames + ")") > DB_RESULT_EMPTY)
+    {
+        const std::vector<DatabaseRow> & rows = db.GetRows();
+
+        for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+            accounts[LowerCase(itr->fields[1].GetString())] = itr->fields[0].GetUInt32();
+    }
+
+    for (std::vector<ActivityEntry>::iterator itr = entries.begin(); itr != entries.end(); ++itr)
+    {
+        if (itr->accountId)
+            continue;
+
+        std::map<std::string, uint32>::const_iterator account = accounts.find(LowerCase(itr->username));
+        if (account != accounts.end())
+            itr->accountId = account->second;
+    }
+}
+
+void ActivityLog::Write(std::vector<ActivityEntry> & entries)
+{
+    Database db;
+
+    // activities for not existing accounts are skipped as before
+    if (db.Connect(DB_ACCOUNTS_DATA))
+        ResolveAccounts(entries, db);
+
+    if (!db.Connect(DB_PANEL_DATA))
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        failed += entries.size();
+        return;
+    }
+
+    std::string query;
+    uint32 rows = 0, stored = 0, lost = 0;
+
+    for (std::vector<ActivityEntry>::const_iterator itr = entries.begin(); itr != entries.end(); ++itr)
+    {
+        if (!itr->accountId)
+            continue;
+
+        query += rows ? ", " : "INSERT IGNORE INTO Activity VALUES ";
+        query += Misc::GetFormattedString("('%u', FROM_UNIXTIME(%u), '%s', '%s', '%s')", itr->accountId, uint32(itr->time),
+                                          db.EscapeString(itr->ip).c_str(), db.EscapeString(itr->activity).c_str(), db.EscapeString(itr->activityArgs).c_str());
+        ++rows;
+
+        if (rows >= ACTIVITY_ROWS_PER_INSERT)
+        {
+            if (db.ExecuteQuery(query) == DB_RESULT_ERROR)
+                lost += rows;
+            else
+                stored += rows;
+
+            query.clear();
+            rows = 0;
+        }
+    }
+
+    // rest of activities
+    if (rows)
+    {
+        if (db.ExecuteQuery(query) == DB_RESULT_ERROR)
+            lost += rows;
+        else
+            stored += rows;
+    }
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    written += stored;
+    failed += lost;
+}
+
+void ActivityLog::LogLost()
+{
+    uint64 newDropped, newFailed;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+
+        newDropped = dropped - loggedDropped;
+        newFailed = failed - loggedFailed;
+
+        loggedDropped = dropped;
+        loggedFailed = failed;
+    }
+
+    // audit events shouldn't disappear silently
+    if (newDropped || newFailed)
+        Misc::Log(LOG_DB_ERRORS, "Activity log: %llu activities dropped because of full queue, %llu lost because of DB errors",
+                  (unsigned long long)newDropped, (unsigned long long)newFailed);
+}
+
+uint64 ActivityLog::GetWrittenCount()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return written;
+}
+
+uint64 ActivityLog::GetDroppedCount()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return dropped;
+}
+
+uint64 ActivityLog::GetFailedCount()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return failed;
+}
+
+uint32 ActivityLog::GetPendingCount()
+{
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    return pending.size();
+}
+
+volatile ActivityLog * ActivityLog::_activityLog = nullptr;
+std::mutex ActivityLog::_createMutex;
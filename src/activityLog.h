@@ -0,0 +1,113 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACTIVITY_LOG_H_INCLUDED
+#define ACTIVITY_LOG_H_INCLUDED
+
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+
+class Database;
+
+/********************************************//**
+ * \brief Single account activity waiting for write.
+ *
+ * Account can be given by id or by username, username
+ * is resolved to id by writer thread.
+ *
+ ***********************************************/
+
+struct ActivityEntry
+{
+    ActivityEntry() : accountId(0), time(0) {}
+
+    uint32 accountId;           /// account id, 0 when username should be used
+    std::string username;       /// account username (not escaped, it's escaped when query is built)
+    std::string ip;
+    std::string activity;       /// activity text id
+    std::string activityArgs;
+    std::time_t time;           /// time when activity happened
+};
+
+/********************************************//**
+ * \brief Process wide writer for Activity table.
+ *
+ * Activities are only added to buffer by pages, writer thread
+ * stores them in db with multi row inserts when buffer reaches
+ * configured size or after configured interval.
+ * Buffer is bounded - activities added to full buffer are dropped
+ * so pages never wait for audit log.
+ * Dropped and lost activities are logged after each flush.
+ * Buffer is flushed on shutdown.
+ *
+ ***********************************************/
+
+class ActivityLog
+{
+public:
+    static ActivityLog & Instance();
+    static void Shutdown();                             /// writes buffered activities and stops writer (if log was created)
+
+    void Add(uint32 accountId, const std::string & ip, const char * activity, const std::string & activityArgs);
+    void Add(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs);
+
+    uint64 GetWrittenCount();                           /// returns count of activities stored in db
+    uint64 GetDroppedCount();                           /// returns count of activities dropped because of full buffer
+    uint64 GetFailedCount();                            /// returns count of activities lost because of db errors
+    uint32 GetPendingCount();                           /// returns count of activities waiting for write
+
+private:
+    ActivityLog();
+    ActivityLog(const ActivityLog &) {}
+    ~ActivityLog();
+
+    void Add(const ActivityEntry & entry);
+    void Run();                                         /// writer thread loop
+    void Stop();
+    void Write(std::vector<ActivityEntry> & entries);   /// stores given activities in db
+    void LogLost();                                     /// logs activities dropped or lost since previous call
+    void ResolveAccounts(std::vector<ActivityEntry> & entries, Database & db); /// sets account ids for activities added by username
+
+    std::vector<ActivityEntry> pending;
+    uint32 maxPending;
+    uint32 flushSize;
+    int flushInterval;
+    bool stopping;
+
+    uint64 written;
+    uint64 dropped;
+    uint64 failed;
+    uint64 loggedDropped;                               /// dropped count already reported in log
+    uint64 loggedFailed;                                /// failed count already reported in log
+
+    std::thread writer;
+    std::mutex pendingMutex;
+    std::condition_variable pendingCondition;
+
+    static volatile ActivityLog * _activityLog;
+    static std::mutex _createMutex;
+};
+
+#define sActivityLog ActivityLog::Instance()
+
+#endif // ACTIVITY_LOG_H_INCLUDED
@@ -0,0 +1,223 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "compiledTemplate.h"
+
+#include <ostream>
+
+#include "misc.h"
+
+/********************************************//**
+ * \brief Splits placeholder arguments.
+ *
+ * Arguments are separated by spaces, quoted
+ * arguments can contain spaces.
+ *
+ ***********************************************/
+
+static void SplitArguments(const std::string & str, std::vector<Wt::WString> & args)
+{
+    size_t pos = 0;
+
+    while (pos < str.size())
+    {
+        while (pos < str.size() && str[pos] == ' ')
+            ++pos;
+
+        if (pos >= str.size())
+            break;
+
+        size_t end;
+
+        if (str[pos] == '"' || str[pos] == '\'')
+        {
+            end = str.find(str[pos], pos + 1);
+            if (end == std::string::npos)
+                end = str.size();
+
+            args.push_back(Wt::WString::fromUTF8(str.substr(pos + 1, end - pos - 1)));
+            pos = end + 1;
+        }
+        else
+        {
+            end = str.find(' ', pos);
+            if (end == std::string::npos)
+                end = str.size();
+
+            args.push_back(Wt::WString::fromUTF8(str.substr(pos, end - pos)));
+            pos = end;
+        }
+    }
+}
+
+TemplateSegments * TemplateSegments::Compile(const std::string & text)
+{
+    TemplateSegments * compiled = new TemplateSegments();
+    std::vector<TemplateSegment> & segments = compiled->segments;
+    std::vector<uint32> openConditions;
+    std::string literal;
+    size_t pos = 0;
+
+    while (pos < text.size())
+    {
+        size_t start = text.find('$', pos);
+
+        if (start == std::string::npos)
+        {
+            literal.append(text, pos, std::string::npos);
+            break;
+        }
+
+        literal.append(text, pos, start - pos);
+
+        // $${ is escaped ${
+        if (text.compare(start, 3, "$${") == 0)
+        {
+            literal += "${";
+            pos = start + 3;
+            continue;
+        }
+
+        size_t close = text.compare(start, 2, "${") == 0 ? text.find('}', start + 2) : std::string::npos;
+
+        if (close == std::string::npos)
+        {
+            literal += '$';
+            pos = start + 1;
+            continue;
+        }
+
+        if (!literal.empty())
+        {
+            segments.push_back(TemplateSegment());
+            segments.back().text.swap(literal);
+        }
+
+        std::string placeholder = text.substr(start + 2, close - start - 2);
+        pos = close + 1;
+
+        // condition block end
+        if (placeholder.compare(0, 2, "</") == 0)
+        {
+            std::string name = placeholder.substr(2, placeholder.size() - 3);
+
+            if (openConditions.empty() || segments[openConditions.back()].text != name)
+            {
+                Misc::Console(DEBUG_CODE, "%s: condition %s closed but not opened\n", __FUNCTION__, name.c_str());
+                delete compiled;
+                return NULL;
+            }
+
+            segments[openConditions.back()].end = segments.size();
+            openConditions.pop_back();
+            continue;
+        }
+
+        TemplateSegment segment;
+
+        // condition block start
+        if (placeholder.compare(0, 1, "<") == 0)
+        {
+            segment.type = TEMPLATE_SEGMENT_CONDITION;
+            segment.text = placeholder.substr(1, placeholder.size() - 2);
+
+            openConditions.push_back(segments.size());
+            segments.push_back(segment);
+            continue;
+        }
+
+        size_t separator = placeholder.find_first_of(": ");
+
+        segment.type = separator != std::string::npos && placeholder[separator] == ':' ? TEMPLATE_SEGMENT_FUNCTION : TEMPLATE_SEGMENT_VAR;
+        segment.text = placeholder.substr(0, separator);
+
+        if (separator != std::string::npos)
+            SplitArguments(placeholder.substr(separator + 1), segment.args);
+
+        segments.push_back(segment);
+    }
+
+    if (!literal.empty())
+    {
+        segments.push_back(TemplateSegment());
+        segments.back().text.swap(literal);
+    }
+
+    if (!openConditions.empty())
+    {
+        Misc::Console(DEBUG_CODE, "%s: condition %s isn't closed\n", __FUNCTION__, segments[openConditions.back()].text.c_str());
+        delete compiled;
+        return NULL;
+    }
+
+    return compiled;
+}
+
+PanelTemplate::PanelTemplate(Wt::WContainerWidget * parent)
+: Wt::WTemplate(parent)
+{
+}
+
+void PanelTemplate::SetTemplate(const TemplateInfo & tmplt)
+{
+    compiled = tmplt.compiledTemplate;
+
+    // template comes from server files, it isn't filtered so compiled and text version are the same
+    setTemplateText(tmplt.currentTemplate ? Wt::WString::fromUTF8(*tmplt.currentTemplate) : Wt::WString(), Wt::XHTMLUnsafeText);
+}
+
+void PanelTemplate::renderTemplate(std::ostream & result)
+{
+    if (!compiled)
+    {
+        Wt::WTemplate::renderTemplate(result);
+        return;
+    }
+
+    RenderSegments(result, 0, compiled->segments.size());
+}
+
+void PanelTemplate::RenderSegments(std::ostream & result, uint32 begin, uint32 end)
+{
+    for (uint32 i = begin; i < end;)
+    {
+        const TemplateSegment & segment = compiled->segments[i];
+
+        switch (segment.type)
+        {
+            case TEMPLATE_SEGMENT_TEXT:
+                result << segment.text;
+                break;
+            case TEMPLATE_SEGMENT_VAR:
+                resolveString(segment.text, segment.args, result);
+                break;
+            case TEMPLATE_SEGMENT_FUNCTION:
+                if (!resolveFunction(segment.text, segment.args, result))
+                    result << "??" << segment.text << "??";
+                break;
+            case TEMPLATE_SEGMENT_CONDITION:
+                if (conditionValue(segment.text))
+                    RenderSegments(result, i + 1, segment.end);
+
+                // skip whole block
+                i = segment.end;
+                continue;
+        }
+
+        ++i;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPILED_TEMPLATE_H_INCLUDED
+#define COMPILED_TEMPLATE_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Wt/WTemplate>
+
+#include "defines.h"
+
+enum TemplateSegmentType
+{
+    TEMPLATE_SEGMENT_TEXT       = 0,    /**< Literal text. */
+    TEMPLATE_SEGMENT_VAR,               /**< ${name} - bound widget or string. */
+    TEMPLATE_SEGMENT_FUNCTION,          /**< ${function:args} - for example ${tr:key}. */
+    TEMPLATE_SEGMENT_CONDITION          /**< ${<name>} ... ${</name>} block. */
+};
+
+/********************************************//**
+ * \brief Part of compiled template.
+ ***********************************************/
+
+struct TemplateSegment
+{
+    TemplateSegment() : type(TEMPLATE_SEGMENT_TEXT), end(0) {}
+
+    TemplateSegmentType type;
+    std::string text;                   /// literal text or var/function/condition name
+    std::vector<Wt::WString> args;      /// function arguments
+    uint32 end;                         /// for condition - index of first segment after block
+};
+
+/********************************************//**
+ * \brief Template text compiled to segments.
+ *
+ * Template is scanned for placeholders only once
+ * (when .tmplt file is loaded), compiled segments
+ * are shared read only by all sessions.
+ *
+ ***********************************************/
+
+struct TemplateSegments
+{
+    std::vector<TemplateSegment> segments;
+
+    static TemplateSegments * Compile(const std::string & text); /// returns NULL when template has unclosed or mismatched condition blocks
+};
+
+/********************************************//**
+ * \brief WTemplate which renders compiled template.
+ *
+ * Template text is still set in WTemplate (so everything
+ * which depends on it works as before), but rendering
+ * walks compiled segments instead of parsing text
+ * on every render (login/logout, template change).
+ * Without compiled segments WTemplate rendering is used.
+ *
+ ***********************************************/
+
+class PanelTemplate : public Wt::WTemplate
+{
+public:
+    PanelTemplate(Wt::WContainerWidget * parent = 0);
+
+    void SetTemplate(const TemplateInfo & tmplt);       /// sets template text and compiled segments
+
+    void renderTemplate(std::ostream & result);
+
+private:
+    void RenderSegments(std::ostream & result, uint32 begin, uint32 end);
+
+    TemplateSegmentsPtr compiled;
+};
+
+#endif // COMPILED_TEMPLATE_H_INCLUDED
@@ -17,14 +17,35 @@
 
 #include "config.h"
 
+#include <chrono>
 #include <iostream>
+#include <sys/stat.h>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include "databasePool.h"
 #include "misc.h"
 #include "miscCharacter.h"
 
+ConfigData::ConfigData()
+{
+    for (int i = 0; i < INT_CONFIG_COUNT; ++i)
+        configInt[i] = 0;
+
+    for (int i = 0; i < BOOL_CONFIG_COUNT; ++i)
+        configBool[i] = false;
+
+    // there is always at least one realm
+    realmInfos.resize(1);
+}
+
+Config::Config() : watching(false)
+{
+    // empty snapshot until config file is read
+    std::atomic_store(&current, ConfigDataPtr(new ConfigData()));
+}
+
 Config & Config::Instance()
 {
     // if config wasn't initialized yet
@@ -45,37 +66,7 @@ Config & Config::Instance()
     return * const_cast<Config*>(_config);
 }
 
-const std::string & Config::GetConfig(StringConfig option) const
-{
-    return configString[option];
-}
-
-int Config::GetConfig(IntConfig option) const
-{
-    return configInt[option];
-}
-
-bool Config::GetConfig(BoolConfig option) const
-{
-    return configBool[option];
-}
-
-void Config::SetConfig(StringConfig option, const std::string & value)
-{
-    configString[option] = value;
-}
-
-void Config::SetConfig(IntConfig option, const int & value)
-{
-    configInt[option] = value;
-}
-
-void Config::SetConfig(BoolConfig option, bool value)
-{
-    configBool[option] = value;
-}
-
-Location Config::GetStartingLocation(CharacterRaces race) const
+Location ConfigData::GetStartingLocation(CharacterRaces race) const
 {
     // array is from 0 but races from 1
     int raceIndex = race - 1;
@@ -87,7 +78,7 @@ Location Config::GetStartingLocation(CharacterRaces race) const
     return raceLocations[raceIndex];
 }
 
-void Config::SetStartingLocation(CharacterRaces race, Location & loc)
+void ConfigData::SetStartingLocation(CharacterRaces race, Location & loc)
 {
     // array is from 0 but races from 1
     int raceIndex = race - 1;
@@ -99,92 +90,194 @@ void Config::SetStartingLocation(CharacterRaces race, Location & loc)
     raceLocations[raceIndex] = loc;
 }
 
-const RealmInformations & Config::GetRealmInformations(int entry) const
+const RealmInformations & ConfigData::GetRealmInformations(int entry) const
 {
-    if (entry < 0 || entry >= GetConfig(CONFIG_REALMS_COUNT))
+    if (entry < 0 || entry >= int(realmInfos.size()))
         return realmInfos[0];
 
     return realmInfos[entry];
 }
 
-void Config::ReadConfig()
+DatabaseDsn ConfigData::GetAccountsDsn() const
 {
-    if (!_configMutex.try_lock())
-        return;
+    DatabaseDsn dsn;
+    dsn.host = GetConfig(CONFIG_DB_ACCOUNTS_HOST);
+    dsn.login = GetConfig(CONFIG_DB_ACCOUNTS_LOGIN);
+    dsn.password = GetConfig(CONFIG_DB_ACCOUNTS_PASSWORD);
+    dsn.port = GetConfig(CONFIG_DB_ACCOUNTS_PORT);
+    dsn.name = GetConfig(CONFIG_DB_ACCOUNTS_NAME);
+    dsn.poolSize = GetConfig(CONFIG_DB_ACCOUNTS_POOL_SIZE);
+
+    return dsn;
+}
+
+DatabaseDsn ConfigData::GetPanelDsn() const
+{
+    DatabaseDsn dsn;
+    dsn.host = GetConfig(CONFIG_DB_PANEL_HOST);
+    dsn.login = GetConfig(CONFIG_DB_PANEL_LOGIN);
+    dsn.password = GetConfig(CONFIG_DB_PANEL_PASSWORD);
+    dsn.port = GetConfig(CONFIG_DB_PANEL_PORT);
+    dsn.name = GetConfig(CONFIG_DB_PANEL_NAME);
+    dsn.poolSize = GetConfig(CONFIG_DB_PANEL_POOL_SIZE);
+
+    return dsn;
+}
+
+DatabaseDsn ConfigData::GetRealmDsn(int entry) const
+{
+    const RealmInformations & realm = GetRealmInformations(entry);
+
+    DatabaseDsn dsn;
+    dsn.host = realm.dbHost;
+    dsn.login = realm.dbLogin;
+    dsn.password = realm.dbPass;
+    dsn.port = realm.dbPort;
+    dsn.name = realm.dbName;
+    dsn.poolSize = realm.dbPoolSize;
+
+    return dsn;
+}
+
+bool Config::ReadConfig()
+{
+    std::lock_guard<std::mutex> lock(_configMutex);
 
     std::cout << "Preparing config" << std::endl;
 
     // prepare config options
     boost::property_tree::ptree pt;
-    boost::property_tree::xml_parser::read_xml("config.xml", pt);
+    ConfigFileState fileState;
+    GetFileState(fileState);
+
+    try
+    {
+        boost::property_tree::xml_parser::read_xml("config.xml", pt);
+    }
+    catch (boost::property_tree::xml_parser::xml_parser_error & e)
+    {
+        std::cout << "Can't read config: " << e.what() << std::endl;
+        return false;
+    }
+
+    ConfigData * data = new ConfigData();
+
+    try
+    {
+        LoadConfig(pt, data);
+    }
+    catch (boost::property_tree::ptree_error & e)
+    {
+        std::cout << "Can't read config: " << e.what() << std::endl;
+        delete data;
+        return false;
+    }
+
+    if (!ValidateConfig(data))
+    {
+        delete data;
+        return false;
+    }
+
+    // publish new snapshot - old one is freed when nobody uses it
+    std::atomic_store(&current, ConfigDataPtr(data));
+
+    {
+        std::lock_guard<std::mutex> lock(_watchMutex);
+        lastFileState = fileState;
+    }
+
+    return true;
+}
 
+void Config::LoadConfig(const boost::property_tree::ptree & pt, ConfigData * data)
+{
     std::cout << "Setting config values" << std::endl;
 
     std::cout << "    template" << std::endl;
-    SetConfig(CONFIG_DEFAULT_TEMPLATE_NAME, pt.get("template.name", "default"));
-    SetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH, pt.get("template.path.style", "res/templates/default"));
-    SetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH, pt.get("template.path.file", "res/templates/default"));
+    data->SetConfig(CONFIG_DEFAULT_TEMPLATE_NAME, pt.get("template.name", "default"));
+    data->SetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH, pt.get("template.path.style", "res/templates/default"));
+    data->SetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH, pt.get("template.path.file", "res/templates/default"));
 
     std::cout << "    language" << std::endl;
-    SetConfig(CONFIG_LANGUAGE_FILE_PATH, pt.get("language.file.path", "langs/panel"));
+    data->SetConfig(CONFIG_LANGUAGE_FILE_PATH, pt.get("language.file.path", "langs/panel"));
 
     std::cout << "    validator" << std::endl;
-    SetConfig(CONFIG_LOGIN_VALIDATOR, pt.get("validator.login", "[a-zA-Z0-9_-]{6,16}"));
+    data->SetConfig(CONFIG_LOGIN_VALIDATOR, pt.get("validator.login", "[a-zA-Z0-9_-]{6,16}"));
 
     std::cout << "    mail" << std::endl;
-    SetConfig(CONFIG_MAIL_FROM, pt.get("mail.from", "none@none.none"));
-    SetConfig(CONFIG_MAIL_HOST, pt.get("mail.host", "localhost"));
-    SetConfig(CONFIG_MAIL_USER, pt.get("mail.user", ""));
-    SetConfig(CONFIG_MAIL_PASSWORD, pt.get("mail.password", ""));
+    data->SetConfig(CONFIG_MAIL_FROM, pt.get("mail.from", "none@none.none"));
+    data->SetConfig(CONFIG_MAIL_HOST, pt.get("mail.host", "localhost"));
+    data->SetConfig(CONFIG_MAIL_USER, pt.get("mail.user", ""));
+    data->SetConfig(CONFIG_MAIL_PASSWORD, pt.get("mail.password", ""));
 
     std::cout << "    database.panel" << std::endl;
-    SetConfig(CONFIG_DB_PANEL_HOST, pt.get("database.panel.host", "localhost"));
-    SetConfig(CONFIG_DB_PANEL_LOGIN, pt.get("database.panel.login", "panel"));
-    SetConfig(CONFIG_DB_PANEL_PASSWORD, pt.get("database.panel.password", "panel"));
-    SetConfig(CONFIG_DB_PANEL_PORT, pt.get("database.panel.port", 3306));
-    SetConfig(CONFIG_DB_PANEL_NAME, pt.get("database.panel.name", "panel"));
+    data->SetConfig(CONFIG_DB_PANEL_HOST, pt.get("database.panel.host", "localhost"));
+    data->SetConfig(CONFIG_DB_PANEL_LOGIN, pt.get("database.panel.login", "panel"));
+    data->SetConfig(CONFIG_DB_PANEL_PASSWORD, pt.get("database.panel.password", "panel"));
+    data->SetConfig(CONFIG_DB_PANEL_PORT, pt.get("database.panel.port", 3306));
+    data->SetConfig(CONFIG_DB_PANEL_NAME, pt.get("database.panel.name", "panel"));
+    data->SetConfig(CONFIG_DB_PANEL_POOL_SIZE, pt.get("database.panel.pool.size", 0));
 
     std::cout << "    database.accounts" << std::endl;
-    SetConfig(CONFIG_DB_ACCOUNTS_HOST, pt.get("database.accounts.host", "localhost"));
-    SetConfig(CONFIG_DB_ACCOUNTS_LOGIN, pt.get("database.accounts.login", "panel"));
-    SetConfig(CONFIG_DB_ACCOUNTS_PASSWORD, pt.get("database.accounts.password", "panel"));
-    SetConfig(CONFIG_DB_ACCOUNTS_PORT, pt.get("database.accounts.port", 3306));
-    SetConfig(CONFIG_DB_ACCOUNTS_NAME, pt.get("database.accounts.name", "accounts"));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_HOST, pt.get("database.accounts.host", "localhost"));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_LOGIN, pt.get("database.accounts.login", "panel"));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_PASSWORD, pt.get("database.accounts.password", "panel"));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_PORT, pt.get("database.accounts.port", 3306));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_NAME, pt.get("database.accounts.name", "accounts"));
+    data->SetConfig(CONFIG_DB_ACCOUNTS_POOL_SIZE, pt.get("database.accounts.pool.size", 0));
 
     std::cout << "    database" << std::endl;
-    SetConfig(CONFIG_DB_SHOW_ERRORS, pt.get("database.show.errors", true));
+    data->SetConfig(CONFIG_DB_SHOW_ERRORS, pt.get("database.show.errors", true));
+    data->SetConfig(CONFIG_DB_POOL_SIZE, pt.get("database.pool.size", 10));
+    data->SetConfig(CONFIG_DB_POOL_IDLE_TIMEOUT, pt.get("database.pool.idle", 300));
+    data->SetConfig(CONFIG_DB_POOL_PING_INTERVAL, pt.get("database.pool.ping", 5));
+    data->SetConfig(CONFIG_DB_POOL_WAIT_TIMEOUT, pt.get("database.pool.wait", 5));
+    data->SetConfig(CONFIG_DB_EXECUTOR_THREADS, pt.get("database.executor.threads", 4));
+    data->SetConfig(CONFIG_DB_EXECUTOR_QUEUE_SIZE, pt.get("database.executor.queue", 256));
 
     std::cout << "    email" << std::endl;
-    SetConfig(CONFIG_EMAIL_SHOW_CHAR_COUNT, pt.get("email.show.count", 2));
-    SetConfig(CONFIG_EMAIL_HIDE_CHAR_COUNT, pt.get("email.hide.count", 4));
-    SetConfig(CONFIG_EMAIL_HIDE_CHARACTER, pt.get("email.hide.character", "*"));
-    SetConfig(CONFIG_EMAIL_HIDE_DOMAIN, pt.get("email.hide.domain", true));
+    data->SetConfig(CONFIG_EMAIL_SHOW_CHAR_COUNT, pt.get("email.show.count", 2));
+    data->SetConfig(CONFIG_EMAIL_HIDE_CHAR_COUNT, pt.get("email.hide.count", 4));
+    data->SetConfig(CONFIG_EMAIL_HIDE_CHARACTER, pt.get("email.hide.character", "*"));
+    data->SetConfig(CONFIG_EMAIL_HIDE_DOMAIN, pt.get("email.hide.domain", true));
 
     std::cout << "    server" << std::endl;
-    SetConfig(CONFIG_ALLOW_TWO_SIDE_ACCOUNTS, pt.get("server.allow.two-side-accounts", false));
-    SetConfig(CONFIG_REGISTRATION_ENABLED, pt.get("server.registration.enabled", true));
-    SetConfig(CONFIG_REALMS_COUNT, pt.get("server.realms.count", 1));
-    SetConfig(CONFIG_MAX_CHARACTERS_PER_REALM, pt.get("server.max.characters.per.realm", 50));
-    SetConfig(CONFIG_MAX_CHARACTERS_PER_ACCOUNT, pt.get("server.max.characters.per.account", 10));
-    SetConfig(CONFIG_STARTING_EXPANSION, pt.get("server.starting.expansion", 1));
+    data->SetConfig(CONFIG_ALLOW_TWO_SIDE_ACCOUNTS, pt.get("server.allow.two-side-accounts", false));
+    data->SetConfig(CONFIG_REGISTRATION_ENABLED, pt.get("server.registration.enabled", true));
+    data->SetConfig(CONFIG_REALMS_COUNT, pt.get("server.realms.count", 1));
+    data->SetConfig(CONFIG_MAX_CHARACTERS_PER_REALM, pt.get("server.max.characters.per.realm", 50));
+    data->SetConfig(CONFIG_MAX_CHARACTERS_PER_ACCOUNT, pt.get("server.max.characters.per.account", 10));
+    data->SetConfig(CONFIG_STARTING_EXPANSION, pt.get("server.starting.expansion", 1));
 
     std::cout << "    options" << std::endl;
-    SetConfig(CONFIG_OPTIONS_DEBUG, pt.get("options.debug", int(DEBUG_NONE)));
-    SetConfig(CONFIG_OPTIONS_LOG, pt.get("options.log", int(LOG_DB)));
+    data->SetConfig(CONFIG_OPTIONS_DEBUG, pt.get("options.debug", int(DEBUG_NONE)));
+    data->SetConfig(CONFIG_OPTIONS_LOG, pt.get("options.log", int(LOG_DB)));
+    data->SetConfig(CONFIG_OPTIONS_RELOAD_INTERVAL, pt.get("options.reload", 5));
+    data->SetConfig(CONFIG_OPTIONS_STATS_INTERVAL, pt.get("options.stats", 300));
 
     std::cout << "    password" << std::endl;
-    SetConfig(CONFIG_PASSWORD_LENGTH_MIN, pt.get("password.length.min", 6));
-    SetConfig(CONFIG_PASSWORD_LENGTH_MAX, pt.get("password.length.max", 16));
-    SetConfig(CONFIG_PASSWORD_GEN_ASCII_START, pt.get("password.generation.ascii.start", 33));
-    SetConfig(CONFIG_PASSWORD_GEN_ASCII_STOP, pt.get("password.generation.ascii.stop", 126));
+    data->SetConfig(CONFIG_PASSWORD_LENGTH_MIN, pt.get("password.length.min", 6));
+    data->SetConfig(CONFIG_PASSWORD_LENGTH_MAX, pt.get("password.length.max", 16));
+    data->SetConfig(CONFIG_PASSWORD_GEN_ASCII_START, pt.get("password.generation.ascii.start", 33));
+    data->SetConfig(CONFIG_PASSWORD_GEN_ASCII_STOP, pt.get("password.generation.ascii.stop", 126));
 
     std::cout << "    interval" << std::endl;
-    SetConfig(CONFIG_INTERVAL_UPDATE_CHARACTERS, pt.get("interval.update.characters", 5));
-    SetConfig(CONFIG_INTERVAL_VOTE, pt.get("interval.vote", 12));
+    data->SetConfig(CONFIG_INTERVAL_UPDATE_CHARACTERS, pt.get("interval.update.characters", 5));
+    data->SetConfig(CONFIG_INTERVAL_UPDATE_STATUS, pt.get("interval.update.status", 60));
+    data->SetConfig(CONFIG_INTERVAL_STATUS_TIMEOUT, pt.get("interval.status.timeout", 15));
+    data->SetConfig(CONFIG_INTERVAL_UPDATE_TEMPLATES, pt.get("interval.update.templates", 60));
+    data->SetConfig(CONFIG_INTERVAL_VOTE, pt.get("interval.vote", 12));
+
+    std::cout << "    status" << std::endl;
+    data->SetConfig(CONFIG_STATUS_HISTORY_FILE, pt.get("status.history.file", "status.history"));
 
     std::cout << "    activity" << std::endl;
-    SetConfig(CONFIG_ACTIVITY_LIMIT_PANEL, pt.get("activity.limit.panel", 100));
-    SetConfig(CONFIG_ACTIVITY_LIMIT_SERVER, pt.get("activity.limit.server", 100));
+    data->SetConfig(CONFIG_ACTIVITY_LIMIT_PANEL, pt.get("activity.limit.panel", 100));
+    data->SetConfig(CONFIG_ACTIVITY_LIMIT_SERVER, pt.get("activity.limit.server", 100));
+    data->SetConfig(CONFIG_ACTIVITY_QUEUE_SIZE, pt.get("activity.queue", 10000));
+    data->SetConfig(CONFIG_ACTIVITY_FLUSH_SIZE, pt.get("activity.flush.size", 50));
+    data->SetConfig(CONFIG_ACTIVITY_FLUSH_INTERVAL, pt.get("activity.flush.interval", 2));
 
     Location loc;
 
@@ -193,75 +286,82 @@ void Config::ReadConfig()
     loc.posX = pt.get("race.location.Human.x",      -8949.95);
     loc.posY = pt.get("race.location.Human.y",      -132.493);
     loc.posZ = pt.get("race.location.Human.z",      83.5312);
-    SetStartingLocation(RACE_HUMAN, loc);
+    data->SetStartingLocation(RACE_HUMAN, loc);
 
     loc.mapId = pt.get("race.location.Orc.map",     1);
     loc.zone = pt.get("race.location.Orc.zone",     14);
     loc.posX = pt.get("race.location.Orc.x",        -618.518);
     loc.posY = pt.get("race.location.Orc.y",        -4251.67);
     loc.posZ = pt.get("race.location.Orc.z",        38.718);
-    SetStartingLocation(RACE_ORC, loc);
+    data->SetStartingLocation(RACE_ORC, loc);
 
     loc.mapId = pt.get("race.location.Dwarf.map",   0);
     loc.zone = pt.get("race.location.Dwarf.zone",   1);
     loc.posX = pt.get("race.location.Dwarf.x",      -6240.32);
     loc.posY = pt.get("race.location.Dwarf.y",      331.033);
     loc.posZ = pt.get("race.location.Dwarf.z",      382.758);
-    SetStartingLocation(RACE_DWARF, loc);
+    data->SetStartingLocation(RACE_DWARF, loc);
 
     loc.mapId = pt.get("race.location.NightElf.map",    1);
     loc.zone = pt.get("race.location.NightElf.zone",    141);
     loc.posX = pt.get("race.location.NightElf.x",       10311.3);
     loc.posY = pt.get("race.location.NightElf.y",       832.463);
     loc.posZ = pt.get("race.location.NightElf.z",       1326.41);
-    SetStartingLocation(RACE_NIGHT_ELF, loc);
+    data->SetStartingLocation(RACE_NIGHT_ELF, loc);
 
     loc.mapId = pt.get("race.location.Undead.map",  0);
     loc.zone = pt.get("race.location.Undead.zone",  85);
     loc.posX = pt.get("race.location.Undead.x",     1676.71);
     loc.posY = pt.get("race.location.Undead.y",     1678.31);
     loc.posZ = pt.get("race.location.Undead.z",     121.67);
-    SetStartingLocation(RACE_UNDEAD, loc);
+    data->SetStartingLocation(RACE_UNDEAD, loc);
 
     loc.mapId = pt.get("race.location.Tauren.map",  1);
     loc.zone = pt.get("race.location.Tauren.zone",  215);
     loc.posX = pt.get("race.location.Tauren.x",     -2917.58);
     loc.posY = pt.get("race.location.Tauren.y",     -257.98);
     loc.posZ = pt.get("race.location.Tauren.z",     52.9968);
-    SetStartingLocation(RACE_TAUREN, loc);
+    data->SetStartingLocation(RACE_TAUREN, loc);
 
     loc.mapId = pt.get("race.location.Gnome.map",   0);
     loc.zone = pt.get("race.location.Gnome.zone",   1);
     loc.posX = pt.get("race.location.Gnome.x",      -6240.32);
     loc.posY = pt.get("race.location.Gnome.y",      331.033);
     loc.posZ = pt.get("race.location.Gnome.z",      382.758);
-    SetStartingLocation(RACE_GNOME, loc);
+    data->SetStartingLocation(RACE_GNOME, loc);
 
     loc.mapId = pt.get("race.location.Troll.map",   1);
     loc.zone = pt.get("race.location.Troll.zone",   14);
     loc.posX = pt.get("race.location.Troll.x",      -618.518);
     loc.posY = pt.get("race.location.Troll.y",      -4251.67);
     loc.posZ = pt.get("race.location.Troll.z",      38.718);
-    SetStartingLocation(RACE_TROLL, loc);
+    data->SetStartingLocation(RACE_TROLL, loc);
 
     loc.mapId = pt.get("race.location.BloodElf.map",    530);
     loc.zone = pt.get("race.location.BloodElf.zone",    3431);
     loc.posX = pt.get("race.location.BloodElf.x",       10349.6);
     loc.posY = pt.get("race.location.BloodElf.y",       -6357.29);
     loc.posZ = pt.get("race.location.BloodElf.z",       33.4026);
-    SetStartingLocation(RACE_BLOOD_ELF, loc);
+    data->SetStartingLocation(RACE_BLOOD_ELF, loc);
 
     loc.mapId = pt.get("race.location.Draenei.map", 530);
     loc.zone = pt.get("race.location.Draenei.zone", 3526);
     loc.posX = pt.get("race.location.Draenei.x",    -3961.64);
     loc.posY = pt.get("race.location.Draenei.y",    -13931.2);
     loc.posZ = pt.get("race.location.Draenei.z",    100.615);
-    SetStartingLocation(RACE_DRAENEI, loc);
+    data->SetStartingLocation(RACE_DRAENEI, loc);
 
     std::cout << "Race locations setted" << std::endl;
 
-    int realmCount = GetConfig(CONFIG_REALMS_COUNT);
-    realmInfos = new RealmInformations[realmCount];
+    int realmCount = data->GetConfig(CONFIG_REALMS_COUNT);
+
+    if (realmCount < 1)
+    {
+        realmCount = 1;
+        data->SetConfig(CONFIG_REALMS_COUNT, realmCount);
+    }
+
+    data->realmInfos.resize(realmCount);
 
     std::cout << "Parsing realms options" << std::endl;
 
@@ -269,22 +369,143 @@ void Config::ReadConfig()
     {
         std::string partialOption = Misc::GetFormattedString("server.realms.info.%i.", i);
         std::string fullOption = partialOption + "name";
-        realmInfos[i].name = pt.get(fullOption, "None");
-        realmInfos[i].statusUrl = pt.get(partialOption + "statusurl", "http://localhost/status.prsr");
-        realmInfos[i].additionalInfo = pt.get(partialOption + "additional", "");
-        realmInfos[i].realmId = pt.get(partialOption + "id", realmCount);
-        realmInfos[i].dbHost = pt.get(partialOption + "dbhost", "localhost");
-        realmInfos[i].dbLogin = pt.get(partialOption + "dblogin", "panel");
-        realmInfos[i].dbPass = pt.get(partialOption + "dbpass", "panel");
-        realmInfos[i].dbPort = pt.get(partialOption + "dbport", 3306);
-        realmInfos[i].dbName = pt.get(partialOption + "dbname", "panel");
+        data->realmInfos[i].name = pt.get(fullOption, "None");
+        data->realmInfos[i].statusUrl = pt.get(partialOption + "statusurl", "http://localhost/status.prsr");
+        data->realmInfos[i].additionalInfo = pt.get(partialOption + "additional", "");
+        data->realmInfos[i].realmId = pt.get(partialOption + "id", realmCount);
+        data->realmInfos[i].dbHost = pt.get(partialOption + "dbhost", "localhost");
+        data->realmInfos[i].dbLogin = pt.get(partialOption + "dblogin", "panel");
+        data->realmInfos[i].dbPass = pt.get(partialOption + "dbpass", "panel");
+        data->realmInfos[i].dbPort = pt.get(partialOption + "dbport", 3306);
+        data->realmInfos[i].dbName = pt.get(partialOption + "dbname", "panel");
+        data->realmInfos[i].dbPoolSize = pt.get(partialOption + "dbpoolsize", 0);
 
         std::cout << "    Parsed options for realm id " << i << " and partial option " << partialOption << std::endl;
     }
 
     std::cout << "Realms options parsed" << std::endl;
+}
+
+bool Config::ValidateConfig(const ConfigData * data)
+{
+    bool valid = true;
+
+    if (data->GetConfig(CONFIG_DB_PANEL_PORT) <= 0 || data->GetConfig(CONFIG_DB_ACCOUNTS_PORT) <= 0)
+    {
+        std::cout << "Invalid config: database port must be greater than 0" << std::endl;
+        valid = false;
+    }
+
+    if (data->GetConfig(CONFIG_DB_POOL_SIZE) < 0 || data->GetConfig(CONFIG_DB_PANEL_POOL_SIZE) < 0 || data->GetConfig(CONFIG_DB_ACCOUNTS_POOL_SIZE) < 0)
+    {
+        std::cout << "Invalid config: database pool size can't be negative" << std::endl;
+        valid = false;
+    }
+
+    if (data->GetConfig(CONFIG_PASSWORD_LENGTH_MIN) > data->GetConfig(CONFIG_PASSWORD_LENGTH_MAX))
+    {
+        std::cout << "Invalid config: password.length.min is greater than password.length.max" << std::endl;
+        valid = false;
+    }
+
+    for (std::vector<RealmInformations>::const_iterator itr = data->realmInfos.begin(); itr != data->realmInfos.end(); ++itr)
+    {
+        if (itr->dbPort <= 0 || itr->dbPoolSize < 0)
+        {
+            std::cout << "Invalid config: wrong database options for realm " << itr->name << std::endl;
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+bool Config::GetFileState(ConfigFileState & state)
+{
+    struct stat fileStat;
+
+    if (stat("config.xml", &fileStat))
+        return false;
+
+    state.modificationTime = fileStat.st_mtime;
+    state.size = fileStat.st_size;
+
+    return true;
+}
 
-    _configMutex.unlock();
+void Config::StartWatcher()
+{
+    std::lock_guard<std::mutex> lock(_watchMutex);
+
+    if (watching)
+        return;
+
+    watching = true;
+    watcher = std::thread(&Config::WatchConfig, this);
+}
+
+void Config::StopWatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_watchMutex);
+        watching = false;
+    }
+
+    watchCondition.notify_all();
+
+    if (watcher.joinable())
+        watcher.join();
+}
+
+void Config::WatchConfig()
+{
+    std::unique_lock<std::mutex> lock(_watchMutex);
+
+    while (watching)
+    {
+        int interval = GetConfig(CONFIG_OPTIONS_RELOAD_INTERVAL);
+
+        // reloading disabled - only wait for stop
+        if (interval <= 0)
+        {
+            watchCondition.wait(lock);
+            continue;
+        }
+
+        watchCondition.wait_for(lock, std::chrono::seconds(interval));
+
+        if (!watching)
+            break;
+
+        ConfigFileState fileState;
+
+        if (!GetFileState(fileState) || fileState == lastFileState)
+            continue;
+
+        lock.unlock();
+
+        std::cout << "Config file changed - reloading" << std::endl;
+
+        bool loaded = ReadConfig();
+
+        if (loaded)
+        {
+            // idle connections to dbs which aren't in new config would stay open forever
+            sDatabasePoolMgr.PrunePools(*GetSnapshot());
+        }
+
+        lock.lock();
+
+        if (!loaded)
+        {
+            std::cout << "New config is invalid - old one is still used" << std::endl;
+
+            // file changed in last second could be still written (same mtime after finish), so it's read again on next check
+            // otherwise same broken file isn't read again
+            if (std::time(NULL) > fileState.modificationTime + 1)
+                lastFileState = fileState;
+        }
+    }
 }
 
 volatile Config * Config::_config = nullptr;
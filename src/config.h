@@ -27,7 +27,14 @@
 #ifndef CONFIG_H_INCLUDED
 #define CONFIG_H_INCLUDED
 
+#include <condition_variable>
+#include <ctime>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/property_tree/ptree_fwd.hpp>
 
 #include <Wt/WString>
 
@@ -59,6 +66,8 @@ enum StringConfig
     CONFIG_DB_ACCOUNTS_PASSWORD,
     CONFIG_DB_ACCOUNTS_NAME,
 
+    CONFIG_STATUS_HISTORY_FILE,
+
     STRING_CONFIG_COUNT
 };
 
@@ -79,6 +88,8 @@ enum IntConfig
 {
     CONFIG_OPTIONS_DEBUG            = 0,
     CONFIG_OPTIONS_LOG,
+    CONFIG_OPTIONS_RELOAD_INTERVAL,
+    CONFIG_OPTIONS_STATS_INTERVAL,
 
     CONFIG_EMAIL_SHOW_CHAR_COUNT,
     CONFIG_EMAIL_HIDE_CHAR_COUNT,
@@ -91,46 +102,72 @@ enum IntConfig
     CONFIG_DB_PANEL_PORT,
     CONFIG_DB_ACCOUNTS_PORT,
 
+    CONFIG_DB_PANEL_POOL_SIZE,
+    CONFIG_DB_ACCOUNTS_POOL_SIZE,
+    CONFIG_DB_POOL_SIZE,
+    CONFIG_DB_POOL_IDLE_TIMEOUT,
+    CONFIG_DB_POOL_PING_INTERVAL,
+    CONFIG_DB_POOL_WAIT_TIMEOUT,
+
+    CONFIG_DB_EXECUTOR_THREADS,
+    CONFIG_DB_EXECUTOR_QUEUE_SIZE,
+
     CONFIG_REALMS_COUNT,
 
     CONFIG_MAX_CHARACTERS_PER_REALM,
     CONFIG_MAX_CHARACTERS_PER_ACCOUNT,
 
     CONFIG_INTERVAL_UPDATE_CHARACTERS,
+    CONFIG_INTERVAL_UPDATE_STATUS,
+    CONFIG_INTERVAL_STATUS_TIMEOUT,
+    CONFIG_INTERVAL_UPDATE_TEMPLATES,
 
     CONFIG_INTERVAL_VOTE,
 
     CONFIG_ACTIVITY_LIMIT_PANEL,
     CONFIG_ACTIVITY_LIMIT_SERVER,
+    CONFIG_ACTIVITY_QUEUE_SIZE,
+    CONFIG_ACTIVITY_FLUSH_SIZE,
+    CONFIG_ACTIVITY_FLUSH_INTERVAL,
 
     CONFIG_STARTING_EXPANSION,
 
     INT_CONFIG_COUNT
 };
 
-class Config
+/********************************************//**
+ * \brief Values of all config options.
+ *
+ * Snapshot is filled once when config file is read
+ * and never changed after it's published by Config,
+ * so it can be read from any thread without locking.
+ *
+ ***********************************************/
+
+class ConfigData
 {
 public:
-    static Config & Instance();
-
-    void ReadConfig();
+    ConfigData();
 
-    const std::string & GetConfig(StringConfig option) const;
-    int GetConfig(IntConfig option) const;
-    bool GetConfig(BoolConfig option) const;
+    const std::string & GetConfig(StringConfig option) const { return configString[option]; }
+    int GetConfig(IntConfig option) const { return configInt[option]; }
+    bool GetConfig(BoolConfig option) const { return configBool[option]; }
 
-    void SetConfig(StringConfig option, const std::string & value);
-    void SetConfig(IntConfig option, const int & value);
-    void SetConfig(BoolConfig option, bool value);
+    void SetConfig(StringConfig option, const std::string & value) { configString[option] = value; }
+    void SetConfig(IntConfig option, const int & value) { configInt[option] = value; }
+    void SetConfig(BoolConfig option, bool value) { configBool[option] = value; }
 
     Location GetStartingLocation(CharacterRaces race) const;
     void SetStartingLocation(CharacterRaces race, Location & loc);
 
     const RealmInformations & GetRealmInformations(int entry) const;
 
+    DatabaseDsn GetAccountsDsn() const;
+    DatabaseDsn GetPanelDsn() const;
+    DatabaseDsn GetRealmDsn(int entry) const;
+
 private:
-    Config() {}
-    Config(const Config &) {}
+    friend class Config;
 
     std::string configString[STRING_CONFIG_COUNT];
     int configInt[INT_CONFIG_COUNT];
@@ -138,7 +175,85 @@ private:
 
     Location raceLocations[10];
 
-    RealmInformations * realmInfos;
+    std::vector<RealmInformations> realmInfos;
+};
+
+typedef std::shared_ptr<const ConfigData> ConfigDataPtr;
+
+/********************************************//**
+ * \brief Config file state used to detect changes.
+ *
+ * Modification time has one second resolution, so size
+ * is compared too (file saved twice in same second).
+ *
+ ***********************************************/
+
+struct ConfigFileState
+{
+    ConfigFileState() : modificationTime(0), size(0) {}
+
+    bool operator==(const ConfigFileState & state) const { return modificationTime == state.modificationTime && size == state.size; }
+    bool operator!=(const ConfigFileState & state) const { return !(*this == state); }
+
+    std::time_t modificationTime;
+    uint64 size;
+};
+
+/********************************************//**
+ * \brief Access point to current config snapshot.
+ *
+ * Config file is read on start (ReadConfig) into new
+ * ConfigData which is then published as shared pointer
+ * (std::atomic_load/atomic_store). Getters only take
+ * that pointer - snapshot itself isn't locked or copied.
+ * Watcher thread checks config file and when it was changed
+ * new snapshot is read and swapped in (invalid file is ignored).
+ * Old snapshot is freed when last code which took it
+ * (GetSnapshot) finishes, so getters return values
+ * instead of references to snapshot members.
+ *
+ ***********************************************/
+
+class Config
+{
+public:
+    static Config & Instance();
+
+    bool ReadConfig();                                  /// reads config file and publishes new snapshot, returns false on error
+
+    void StartWatcher();                                /// starts thread which reloads config when file changes
+    void StopWatcher();
+
+    ConfigDataPtr GetSnapshot() const { return std::atomic_load(&current); } /// returns current snapshot (use it for consistent values of many options)
+
+    std::string GetConfig(StringConfig option) const { return GetSnapshot()->GetConfig(option); }
+    int GetConfig(IntConfig option) const { return GetSnapshot()->GetConfig(option); }
+    bool GetConfig(BoolConfig option) const { return GetSnapshot()->GetConfig(option); }
+
+    Location GetStartingLocation(CharacterRaces race) const { return GetSnapshot()->GetStartingLocation(race); }
+    RealmInformations GetRealmInformations(int entry) const { return GetSnapshot()->GetRealmInformations(entry); }
+
+    // connection data is copied from one snapshot
+    DatabaseDsn GetAccountsDsn() const { return GetSnapshot()->GetAccountsDsn(); }
+    DatabaseDsn GetPanelDsn() const { return GetSnapshot()->GetPanelDsn(); }
+    DatabaseDsn GetRealmDsn(int entry) const { return GetSnapshot()->GetRealmDsn(entry); }
+
+private:
+    Config();
+    Config(const Config &) {}
+
+    void LoadConfig(const boost::property_tree::ptree & pt, ConfigData * data); /// fills snapshot with values from config file
+    bool ValidateConfig(const ConfigData * data);       /// returns false when snapshot can't be used
+    void WatchConfig();                                 /// watcher thread loop
+    static bool GetFileState(ConfigFileState & state);  /// reads config file modification time and size, returns false on error
+
+    ConfigDataPtr current;                              /// published snapshot (accessed only by atomic_load/atomic_store)
+
+    std::thread watcher;
+    bool watching;
+    ConfigFileState lastFileState;                      /// state of last read config file (guarded by _watchMutex)
+    std::mutex _watchMutex;
+    std::condition_variable watchCondition;
 
     static volatile Config * _config;
     static std::mutex _createMutex;
@@ -147,17 +262,9 @@ private:
 
 #define sConfig Config::Instance()
 
-#define DB_ACCOUNTS_DATA sConfig.GetConfig(CONFIG_DB_ACCOUNTS_HOST), sConfig.GetConfig(CONFIG_DB_ACCOUNTS_LOGIN), \
-                         sConfig.GetConfig(CONFIG_DB_ACCOUNTS_PASSWORD),\
-                         sConfig.GetConfig(CONFIG_DB_ACCOUNTS_PORT), sConfig.GetConfig(CONFIG_DB_ACCOUNTS_NAME)
-
-#define DB_PANEL_DATA   sConfig.GetConfig(CONFIG_DB_PANEL_HOST), sConfig.GetConfig(CONFIG_DB_PANEL_LOGIN), \
-                        sConfig.GetConfig(CONFIG_DB_PANEL_PASSWORD),\
-                        sConfig.GetConfig(CONFIG_DB_PANEL_PORT), sConfig.GetConfig(CONFIG_DB_PANEL_NAME)
-
-#define DB_REALM_DATA(a)    sConfig.GetRealmInformations(a).dbHost, sConfig.GetRealmInformations(a).dbLogin, \
-                            sConfig.GetRealmInformations(a).dbPass, sConfig.GetRealmInformations(a).dbPort, \
-                            sConfig.GetRealmInformations(a).dbName
+#define DB_ACCOUNTS_DATA    sConfig.GetAccountsDsn()
+#define DB_PANEL_DATA       sConfig.GetPanelDsn()
+#define DB_REALM_DATA(a)    sConfig.GetRealmDsn(a)
 
 #endif // CONFIG_H_INCLUDED
 
@@ -20,71 +20,306 @@
 #include <cstdarg>
 #include <cstring>
 
+#include "databasePool.h"
 #include "misc.h"
 
 /// DatabaseField
 
-Wt::WString DatabaseField::GetWString()
+Wt::WString DatabaseField::GetWString() const
 {
+    return data ? WString::fromUTF8(std::string(data, length)) : WString();
+}
+
+const char * DatabaseField::GetCString() const
+{
+    return data ? data : "";
+}
+
+std::string DatabaseField::GetString() const
+{
+    return data ? std::string(data, length) : std::string();
+}
+
+// parses decimal number directly from result buffer, stops on first non digit character like sscanf did
+static uint64 ParseUnsigned(const char * data, uint32 length)
+{
+    uint64 value = 0;
+
+    if (!data)
+        return value;
+
+    const char * end = data + length;
+
+    while (data != end && (*data == ' ' || *data == '+'))
+        ++data;
+
+    for (; data != end && *data >= '0' && *data <= '9'; ++data)
+        value = value * 10 + (*data - '0');
+
     return value;
 }
 
-const char * DatabaseField::GetCString()
+static int64 ParseSigned(const char * data, uint32 length)
+{
+    if (!data)
+        return 0;
+
+    const char * end = data + length;
+
+    while (data != end && *data == ' ')
+        ++data;
+
+    if (data != end && *data == '-')
+        return -int64(ParseUnsigned(data + 1, end - data - 1));
+
+    return int64(ParseUnsigned(data, end - data));
+}
+
+uint64 DatabaseField::GetUInt64() const
 {
-    return value.toUTF8().c_str();
+    return ParseUnsigned(data, length);
 }
 
-std::string DatabaseField::GetString()
+uint32 DatabaseField::GetUInt32() const
 {
-    return value.toUTF8();
+    return uint32(ParseUnsigned(data, length));
 }
 
-uint64 DatabaseField::GetUInt64()
+int DatabaseField::GetInt() const
 {
-    uint64 tmp = 0;
-    sscanf(value.toUTF8().c_str(), "%lu", &tmp);
-    return tmp;
+    return int(ParseSigned(data, length));
 }
 
-uint32 DatabaseField::GetUInt32()
+bool DatabaseField::GetBool() const
 {
-    uint32 tmp = 0;
-    sscanf(value.toUTF8().c_str(), "%u", &tmp);
-    return tmp;
+    return ParseSigned(data, length) != 0;
 }
 
-int DatabaseField::GetInt()
+/// DatabaseParams
+
+DatabaseParams & DatabaseParams::AddUInt32(uint32 value)
 {
-    int tmp = 0;
-    sscanf(value.toUTF8().c_str(), "%i", &tmp);
-    return tmp;
+    DatabaseParam param;
+    param.type = DB_PARAM_UINT32;
+    param.uint32Value = value;
+
+    params.push_back(param);
+    return *this;
 }
 
-bool DatabaseField::GetBool()
+DatabaseParams & DatabaseParams::AddUInt64(uint64 value)
 {
-    int tmp = 0;
-    sscanf(value.toUTF8().c_str(), "%i", &tmp);
+    DatabaseParam param;
+    param.type = DB_PARAM_UINT64;
+    param.uint64Value = value;
 
-    if (tmp)
-        return true;
+    params.push_back(param);
+    return *this;
+}
+
+DatabaseParams & DatabaseParams::AddInt32(int32 value)
+{
+    DatabaseParam param;
+    param.type = DB_PARAM_INT32;
+    param.int32Value = value;
+
+    params.push_back(param);
+    return *this;
+}
+
+DatabaseParams & DatabaseParams::AddString(const char * value)
+{
+    DatabaseParam param;
+    param.type = DB_PARAM_STRING;
+    param.stringValue = value ? value : "";
+
+    params.push_back(param);
+    return *this;
+}
+
+DatabaseParams & DatabaseParams::AddString(const std::string & value)
+{
+    DatabaseParam param;
+    param.type = DB_PARAM_STRING;
+    param.stringValue = value;
+
+    params.push_back(param);
+    return *this;
+}
+
+DatabaseParams & DatabaseParams::AddWString(const Wt::WString & value)
+{
+    return AddString(value.toUTF8());
+}
+
+void DatabaseParams::Bind(MYSQL_BIND * binds) const
+{
+    memset(binds, 0, sizeof(MYSQL_BIND) * params.size());
+
+    // mysql needs non const buffers but doesn't modify input params
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+        DatabaseParam & param = const_cast<DatabaseParam&>(params[i]);
+
+        switch (param.type)
+        {
+            case DB_PARAM_UINT32:
+                binds[i].buffer_type = MYSQL_TYPE_LONG;
+                binds[i].buffer = &param.uint32Value;
+                binds[i].is_unsigned = 1;
+                break;
+            case DB_PARAM_UINT64:
+                binds[i].buffer_type = MYSQL_TYPE_LONGLONG;
+                binds[i].buffer = &param.uint64Value;
+                binds[i].is_unsigned = 1;
+                break;
+            case DB_PARAM_INT32:
+                binds[i].buffer_type = MYSQL_TYPE_LONG;
+                binds[i].buffer = &param.int32Value;
+                break;
+            case DB_PARAM_STRING:
+                binds[i].buffer_type = MYSQL_TYPE_STRING;
+                binds[i].buffer = const_cast<char*>(param.stringValue.data());
+                binds[i].buffer_length = param.stringValue.size();
+                break;
+        }
+    }
+}
+
+/// DatabaseResult
+
+DatabaseResult::DatabaseResult(const DatabaseResult & result)
+    : buffer(result.buffer), fields(result.fields), offsets(result.offsets), rows(result.rows), resolved(false)
+{
+    // copied pointers point to other result, they will be resolved on first use
+}
+
+DatabaseResult & DatabaseResult::operator=(const DatabaseResult & result)
+{
+    buffer = result.buffer;
+    fields = result.fields;
+    offsets = result.offsets;
+    rows = result.rows;
+    resolved = false;
+
+    return *this;
+}
 
-    return false;
+void DatabaseResult::Clear()
+{
+    buffer.clear();
+    fields.clear();
+    offsets.clear();
+    rows.clear();
+    resolved = true;
+}
+
+void DatabaseResult::Reserve(uint32 rowsCount, int count)
+{
+    rows.reserve(rows.size() + rowsCount);
+    fields.reserve(fields.size() + rowsCount * count);
+    offsets.reserve(offsets.size() + rowsCount * count);
 }
 
-/// DatabaseRow
-DatabaseRow::DatabaseRow(MYSQL_ROW row, int count)
+void DatabaseResult::AddRow(MYSQL_ROW row, int count, unsigned long * lengths)
 {
-    Misc::Console(DEBUG_DB, "Call DatabaseRow::DatabaseRow(MYSQL_ROW row, int count = %i)\n", count);
+    DatabaseRow tmpRow;
+    tmpRow.count = count;
+    rows.push_back(tmpRow);
 
-    this->count = count;
-    fields = new DatabaseField[count];
     for (int i = 0; i < count; ++i)
-        fields[i].value = WString::fromUTF8(row[i] ? row[i] : "");
+    {
+        DatabaseField field;
+        field.null = row[i] == NULL;
+        field.length = field.null ? 0 : (lengths ? lengths[i] : strlen(row[i]));
+
+        offsets.push_back(buffer.size());
+        fields.push_back(field);
+
+        // every value is NUL terminated so GetCString can return pointer into buffer
+        buffer.insert(buffer.end(), row[i], row[i] + field.length);
+        buffer.push_back('\0');
+    }
+
+    resolved = false;
+}
+
+void DatabaseResult::Resolve()
+{
+    if (resolved)
+        return;
+
+    for (size_t i = 0; i < fields.size(); ++i)
+        fields[i].data = fields[i].null ? NULL : &buffer[offsets[i]];
+
+    size_t firstField = 0;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        rows[i].fields = rows[i].count ? &fields[firstField] : NULL;
+        firstField += rows[i].count;
+    }
+
+    resolved = true;
+}
+
+DatabaseRow * DatabaseResult::GetRow(uint32 index)
+{
+    if (index >= rows.size())
+        return NULL;
+
+    Resolve();
+
+    return &rows[index];
+}
+
+const std::vector<DatabaseRow> & DatabaseResult::GetRows()
+{
+    Resolve();
+
+    return rows;
+}
+
+/// DatabaseCursor
+
+bool DatabaseCursor::Next()
+{
+    current.Clear();
+
+    if (!res)
+        return false;
+
+    MYSQL_ROW row = mysql_fetch_row(res);
+
+    if (!row)
+    {
+        // NULL is returned on end of result and on error
+        if (db->GetErrNo())
+        {
+            error = true;
+            Misc::Log(LOG_DB_ERRORS, "DB Stream query error ! Error [%i]: %s", db->GetErrNo(), db->GetError());
+        }
+
+        Close();
+        return false;
+    }
+
+    current.AddRow(row, count, mysql_fetch_lengths(res));
+    ++readCount;
+
+    return true;
 }
 
-DatabaseRow::~DatabaseRow()
+void DatabaseCursor::Close()
 {
-    delete [] fields;
+    // for unbuffered result mysql_free_result also reads all remaining rows
+    if (res)
+        mysql_free_result(res);
+
+    if (db)
+        db->cursor = NULL;
+
+    res = NULL;
+    db = NULL;
 }
 
 /// Database
@@ -92,6 +327,7 @@ DatabaseRow::~DatabaseRow()
 Database::Database()
 {
     connection = NULL;
+    cursor = NULL;
     loggingEnabled = true;
 }
 
@@ -117,11 +353,23 @@ bool Database::SetPQuery(const char *format, ...)
     if (res == DB_RESULT_ERROR)
         return false;
 
+    // query was longer than buffer - format it once more with proper size instead of truncating
+    if (res >= MAX_QUERY_LEN)
+    {
+        std::vector<char> longQuery(res + 1);
+        va_start(ap, format);
+        vsnprintf(&longQuery[0], longQuery.size(), format, ap);
+        va_end(ap);
+
+        SetQuery(&longQuery[0]);
+        return true;
+    }
+
     SetQuery(szQuery);
     return true;
 }
 
-bool Database::Connect(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db)
+bool Database::Connect(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int poolSize)
 {
     Misc::Console(DEBUG_CODE, "%s(const std::string & host = %s, const std::string & login = %s, const std::string & pass = %s, unsigned int port = %i, const std::string & db = %s)\n",
                     __FUNCTION__, host.c_str(), login.c_str(), password.c_str(), port, db.c_str());
@@ -132,30 +380,41 @@ bool Database::Connect(const std::string & host, const std::string & login, cons
         Clear();
     }
 
-    connection = mysql_init(NULL);
-
-    bool connected = mysql_real_connect(connection, host.c_str(), login.c_str(), password.c_str(), db.c_str(), port, NULL, 0) != NULL;
+    pool = sDatabasePoolMgr.GetPool(host, login, password, port, db, poolSize);
+    connection = pool->Acquire();
 
-    if (!connected)
+    if (!connection)
     {
+        pool.reset();
+
         Misc::Console(DEBUG_DB, "%s: Can't connect to db ! Data: host (%s) login (%s) pass(%s) port(%i) db(%s)\n",
                         __FUNCTION__, host.c_str(), login.c_str(), password.c_str(), port, db.c_str());
     }
 
-    return connected;
+    return connection != NULL;
 }
 
 void Database::Disconnect()
 {
-    if (connection)
-        mysql_close(connection);
+    if (cursor)
+        cursor->Close();
+
+    if (connection && pool)
+        pool->Release(connection);
 
     connection = NULL;
+    pool.reset();
 }
 
 bool Database::SelectDatabase(const std::string & db)
 {
-    return mysql_select_db(connection, db.c_str()) != NULL;
+    if (!connection)
+        return false;
+
+    // connection will go back to pool with other default db, so it mustn't be reused
+    connection->dirty = true;
+
+    return mysql_select_db(connection->mysql, db.c_str()) == 0;
 }
 
 int Database::ExecuteQuery()
@@ -169,7 +428,10 @@ int Database::ExecuteQuery()
     if (loggingEnabled)
         Misc::Log(LOG_DB_QUERY, "DB Query execute: %s", actualQuery.c_str());
 
-    if (mysql_query(connection, actualQuery.c_str()))
+    if (!connection || IsStreaming())
+        return DB_RESULT_ERROR;
+
+    if (mysql_query(connection->mysql, actualQuery.c_str()))
     {
         if (loggingEnabled)
             Misc::Log(LOG_DB_ERRORS, "DB Query error ! Error [%i]: %s", GetErrNo(), GetError());
@@ -178,11 +440,11 @@ int Database::ExecuteQuery()
 
     Misc::Console(DEBUG_DB, "\n\nExecuteQuery(): test2\n");
 
-    MYSQL_RES * res = mysql_store_result(connection);
+    MYSQL_RES * res = mysql_store_result(connection->mysql);
 
     if (res)
     {
-        unsigned int count = mysql_field_count(connection);
+        unsigned int count = mysql_field_count(connection->mysql);
         MYSQL_ROW row;
 
         Misc::Log(LOG_DB_QUERY, "Returned rows: %u", mysql_num_rows(res));
@@ -190,9 +452,11 @@ int Database::ExecuteQuery()
         Misc::Console(DEBUG_DB, "\n\nExecuteQuery(): test3 : count: %i\n", count);
         int i = 0;
 
+        result.Reserve(mysql_num_rows(res), count);
+
         while (row = mysql_fetch_row(res))
         {
-            AddRow(row, count);
+            AddRow(row, count, mysql_fetch_lengths(res));
             i++;
         }
 
@@ -201,9 +465,9 @@ int Database::ExecuteQuery()
         mysql_free_result(res);
     }
 
-    Misc::Console(DEBUG_DB, "\n\nExecuteQuery(): test5: rows.size(): %i\n", (int)rows.size());
+    Misc::Console(DEBUG_DB, "\n\nExecuteQuery(): test5: rows count: %i\n", GetRowsCount());
 
-    return rows.size();
+    return GetRowsCount();
 }
 
 int Database::ExecuteQuery(const std::string & query)
@@ -213,6 +477,177 @@ int Database::ExecuteQuery(const std::string & query)
     return ExecuteQuery();
 }
 
+bool Database::IsStreaming()
+{
+    if (!cursor)
+        return false;
+
+    if (loggingEnabled)
+        Misc::Log(LOG_DB_ERRORS, "DB Query error ! Connection is occupied by open cursor, query: %s", actualQuery.c_str());
+
+    return true;
+}
+
+bool Database::ExecuteStreamQuery(DatabaseCursor & cursor)
+{
+    Misc::Console(DEBUG_DB, "\nCall bool Database::ExecuteStreamQuery() : actualQuery: %s", actualQuery.c_str());
+
+    cursor.Close();
+    cursor.error = false;
+    cursor.readCount = 0;
+
+    Clear();
+
+    if (loggingEnabled)
+        Misc::Log(LOG_DB_QUERY, "DB Stream query execute: %s", actualQuery.c_str());
+
+    if (!connection || IsStreaming())
+        return false;
+
+    if (mysql_query(connection->mysql, actualQuery.c_str()))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Query error ! Error [%i]: %s", GetErrNo(), GetError());
+
+        cursor.error = true;
+        return false;
+    }
+
+    MYSQL_RES * res = mysql_use_result(connection->mysql);
+
+    // query without result (INSERT, UPDATE etc.) - cursor will be empty
+    if (!res)
+        return GetErrNo() == 0;
+
+    cursor.db = this;
+    cursor.res = res;
+    cursor.count = mysql_field_count(connection->mysql);
+
+    this->cursor = &cursor;
+
+    return true;
+}
+
+bool Database::ExecuteStreamQuery(const std::string & query, DatabaseCursor & cursor)
+{
+    actualQuery = query;
+
+    return ExecuteStreamQuery(cursor);
+}
+
+int Database::ExecuteBatch(const std::vector<std::string> & queries)
+{
+    Misc::Console(DEBUG_DB, "\nCall int Database::ExecuteBatch() : queries: %u", uint32(queries.size()));
+
+    Clear();
+    batchResults.clear();
+
+    if (queries.empty())
+        return 0;
+
+    // all results are created before filling so they won't be copied later
+    batchResults.resize(queries.size());
+
+    actualQuery.clear();
+    for (std::vector<std::string>::const_iterator itr = queries.begin(); itr != queries.end(); ++itr)
+    {
+        if (itr != queries.begin())
+            actualQuery += "; ";
+
+        actualQuery += *itr;
+    }
+
+    if (loggingEnabled)
+        Misc::Log(LOG_DB_QUERY, "DB Batch execute: %s", actualQuery.c_str());
+
+    if (!connection || IsStreaming())
+        return DB_RESULT_ERROR;
+
+    // multi statements are enabled only for batch, pooled connections never accept stacked statements for other queries
+    if (mysql_set_server_option(connection->mysql, MYSQL_OPTION_MULTI_STATEMENTS_ON))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Batch error ! Error [%i]: %s", GetErrNo(), GetError());
+        return DB_RESULT_ERROR;
+    }
+
+    bool failed = mysql_query(connection->mysql, actualQuery.c_str()) != 0;
+    uint32 index = 0;
+
+    // status: 0 - there are more results, -1 - no more results, > 0 - error
+    int status = failed ? 1 : 0;
+    while (status == 0)
+    {
+        MYSQL_RES * res = mysql_store_result(connection->mysql);
+
+        if (res)
+        {
+            unsigned int count = mysql_num_fields(res);
+            MYSQL_ROW row;
+
+            if (index < batchResults.size())
+            {
+                batchResults[index].Reserve(mysql_num_rows(res), count);
+
+                while ((row = mysql_fetch_row(res)))
+                    batchResults[index].AddRow(row, count, mysql_fetch_lengths(res));
+            }
+
+            mysql_free_result(res);
+        }
+        else if (mysql_field_count(connection->mysql))
+        {
+            // query should return data but there is no result, connection state is unknown so it won't be reused
+            failed = true;
+            connection->dirty = true;
+            break;
+        }
+
+        ++index;
+
+        status = mysql_next_result(connection->mysql);
+        if (status > 0)
+            failed = true;
+    }
+
+    if (failed)
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Batch error in query %u ! Error [%i]: %s", index, GetErrNo(), GetError());
+
+        // results of next queries must be read, otherwise connection returned to pool is out of sync
+        // when query failed on server, it doesn't execute next ones and there is nothing to read
+        while (status == 0 && mysql_next_result(connection->mysql) == 0)
+        {
+            if (MYSQL_RES * res = mysql_store_result(connection->mysql))
+                mysql_free_result(res);
+        }
+    }
+
+    // connection which can't be switched back isn't returned to pool
+    if (!connection->dirty && mysql_set_server_option(connection->mysql, MYSQL_OPTION_MULTI_STATEMENTS_OFF))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Batch error ! Error [%i]: %s", GetErrNo(), GetError());
+        connection->dirty = true;
+    }
+
+    if (failed)
+        return DB_RESULT_ERROR;
+
+    Misc::Log(LOG_DB_QUERY, "Executed batch queries: %u", index);
+
+    return index;
+}
+
+DatabaseResult * Database::GetBatchResult(uint32 index)
+{
+    if (index >= batchResults.size())
+        return NULL;
+
+    return &batchResults[index];
+}
+
 int Database::ExecutePQuery(const char * format, ...)
 {
     va_list ap;
@@ -224,24 +659,207 @@ int Database::ExecutePQuery(const char * format, ...)
     if (res == DB_RESULT_ERROR)
         return DB_RESULT_ERROR;
 
-    SetQuery(szQuery);
+    // query was longer than buffer - format it once more with proper size instead of truncating
+    if (res >= MAX_QUERY_LEN)
+    {
+        std::vector<char> longQuery(res + 1);
+        va_start(ap, format);
+        vsnprintf(&longQuery[0], longQuery.size(), format, ap);
+        va_end(ap);
+
+        SetQuery(&longQuery[0]);
+    }
+    else
+        SetQuery(szQuery);
 
     return ExecuteQuery();
 }
 
+MYSQL_STMT * Database::GetStatement(const char * sql)
+{
+    std::map<std::string, MYSQL_STMT*>::const_iterator itr = connection->statements.find(sql);
+    if (itr != connection->statements.end())
+        return itr->second;
+
+    MYSQL_STMT * stmt = mysql_stmt_init(connection->mysql);
+    if (!stmt)
+        return NULL;
+
+    if (mysql_stmt_prepare(stmt, sql, strlen(sql)))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Statement prepare error ! Error [%i]: %s", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+
+        mysql_stmt_close(stmt);
+        return NULL;
+    }
+
+    // needed to get proper buffer sizes for results
+    my_bool updateMaxLength = 1;
+    mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength);
+
+    connection->statements[sql] = stmt;
+
+    return stmt;
+}
+
+void Database::DropStatement(const char * sql)
+{
+    std::map<std::string, MYSQL_STMT*>::iterator itr = connection->statements.find(sql);
+    if (itr == connection->statements.end())
+        return;
+
+    mysql_stmt_close(itr->second);
+    connection->statements.erase(itr);
+}
+
+int Database::ExecuteStatement(const char * sql)
+{
+    return ExecuteStatement(sql, DatabaseParams());
+}
+
+int Database::ExecuteStatement(const char * sql, const DatabaseParams & params)
+{
+    Misc::Console(DEBUG_DB, "\nCall int Database::ExecuteStatement() : sql: %s", sql);
+
+    Clear();
+
+    actualQuery = sql;
+
+    if (loggingEnabled)
+        Misc::Log(LOG_DB_QUERY, "DB Statement execute: %s", sql);
+
+    if (!connection || IsStreaming())
+        return DB_RESULT_ERROR;
+
+    MYSQL_STMT * stmt = GetStatement(sql);
+
+    if (!stmt)
+        return DB_RESULT_ERROR;
+
+    if (mysql_stmt_param_count(stmt) != params.GetCount())
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Statement error ! Wrong params count: %u (expected %lu)", uint32(params.GetCount()), mysql_stmt_param_count(stmt));
+        return DB_RESULT_ERROR;
+    }
+
+    std::vector<MYSQL_BIND> paramBinds(params.GetCount());
+
+    if (!paramBinds.empty())
+    {
+        params.Bind(&paramBinds[0]);
+
+        if (mysql_stmt_bind_param(stmt, &paramBinds[0]))
+        {
+            if (loggingEnabled)
+                Misc::Log(LOG_DB_ERRORS, "DB Statement bind error ! Error [%i]: %s", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+            return DB_RESULT_ERROR;
+        }
+    }
+
+    if (mysql_stmt_execute(stmt))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Statement error ! Error [%i]: %s", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+
+        // statement can be invalid after error (lost connection for example) so prepare it once again next time
+        DropStatement(sql);
+        return DB_RESULT_ERROR;
+    }
+
+    MYSQL_RES * meta = mysql_stmt_result_metadata(stmt);
+
+    // no result set (INSERT, UPDATE etc.)
+    if (!meta)
+        return GetRowsCount();
+
+    if (mysql_stmt_store_result(stmt))
+    {
+        if (loggingEnabled)
+            Misc::Log(LOG_DB_ERRORS, "DB Statement store error ! Error [%i]: %s", mysql_stmt_errno(stmt), mysql_stmt_error(stmt));
+
+        mysql_free_result(meta);
+        DropStatement(sql);
+        return DB_RESULT_ERROR;
+    }
+
+    unsigned int count = mysql_num_fields(meta);
+    MYSQL_FIELD * fields = mysql_fetch_fields(meta);
+
+    std::vector<MYSQL_BIND> resultBinds(count);
+    std::vector<std::vector<char> > buffers(count);
+    std::vector<unsigned long> lengths(count);
+    std::vector<my_bool> nulls(count);
+    std::vector<my_bool> errors(count);
+    std::vector<char*> row(count);
+
+    memset(&resultBinds[0], 0, sizeof(MYSQL_BIND) * count);
+
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        // numbers are converted to text by client library and max_length can contain binary size for them
+        buffers[i].resize(fields[i].max_length < 32 ? 33 : fields[i].max_length + 1);
+
+        resultBinds[i].buffer_type = MYSQL_TYPE_STRING;
+        resultBinds[i].buffer = &buffers[i][0];
+        resultBinds[i].buffer_length = buffers[i].size();
+        resultBinds[i].length = &lengths[i];
+        resultBinds[i].is_null = &nulls[i];
+        resultBinds[i].error = &errors[i];
+    }
+
+    mysql_stmt_bind_result(stmt, &resultBinds[0]);
+
+    result.Reserve(mysql_stmt_num_rows(stmt), count);
+
+    int fetchResult;
+    while ((fetchResult = mysql_stmt_fetch(stmt)) == 0 || fetchResult == MYSQL_DATA_TRUNCATED)
+    {
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            // buffer was too small - enlarge and fetch column once again
+            if (errors[i] && lengths[i] >= buffers[i].size())
+            {
+                buffers[i].resize(lengths[i] + 1);
+
+                resultBinds[i].buffer = &buffers[i][0];
+                resultBinds[i].buffer_length = buffers[i].size();
+
+                mysql_stmt_fetch_column(stmt, &resultBinds[i], i, 0);
+                mysql_stmt_bind_result(stmt, &resultBinds[0]);
+            }
+
+            if (nulls[i])
+                row[i] = NULL;
+            else
+            {
+                buffers[i][lengths[i]] = '\0';
+                row[i] = &buffers[i][0];
+            }
+        }
+
+        AddRow(&row[0], count, &lengths[0]);
+    }
+
+    mysql_free_result(meta);
+    mysql_stmt_free_result(stmt);
+
+    Misc::Log(LOG_DB_QUERY, "Returned rows: %u", uint32(GetRowsCount()));
+
+    return GetRowsCount();
+}
+
 std::string Database::EscapeString(const char * str)
 {
     size_t len = strlen(str);
-    char * tmp;
-    tmp = new char[len];
-
-    mysql_real_escape_string(connection, tmp, str, len);
 
-    std::string tmpString = tmp;
+    // escaped string can be twice as long + terminating NUL
+    std::vector<char> tmp(len * 2 + 1);
 
-    delete [] tmp;
+    unsigned long escapedLen = mysql_real_escape_string(connection->mysql, &tmp[0], str, len);
 
-    return tmpString;
+    return std::string(&tmp[0], escapedLen);
 }
 
 std::string Database::EscapeString(const std::string & str)
@@ -256,48 +874,36 @@ std::string Database::EscapeString(const Wt::WString & str)
 
 const char * Database::GetError()
 {
-    return mysql_error(connection);
+    return connection ? mysql_error(connection->mysql) : "";
 }
 
 unsigned int Database::GetErrNo()
 {
-    return mysql_errno(connection);
+    return connection ? mysql_errno(connection->mysql) : 0;
 }
 
 void Database::Clear()
 {
-    for (std::list<DatabaseRow*>::iterator itr = rows.begin(); itr != rows.end(); ++itr)
-        delete *itr;
-
-    rows.clear();
+    result.Clear();
 }
 
-void Database::AddRow(MYSQL_ROW row, int count)
+void Database::AddRow(MYSQL_ROW row, int count, unsigned long * lengths)
 {
     if (row && count > 0)
-        rows.push_back(new DatabaseRow(row, count));
+        result.AddRow(row, count, lengths);
 }
 
 DatabaseRow * Database::GetRow(uint32 index)
 {
-    if (index >= rows.size())
-        return NULL;
-
-    std::list<DatabaseRow*>::iterator itr = rows.begin();
-    std::advance(itr, index);
-
-    return *itr;
+    return result.GetRow(index);
 }
 
 DatabaseRow * Database::GetRow()
 {
-    if (rows.empty())
-        return NULL;
-
-    return rows.front();
+    return result.GetRow(0);
 }
 
-std::list<DatabaseRow*> Database::GetRows()
+const std::vector<DatabaseRow> & Database::GetRows()
 {
-    return rows;
+    return result.GetRows();
 }
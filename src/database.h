@@ -24,38 +24,166 @@
 #endif
 
 #include <list>
+#include <memory>
+#include <vector>
 #include <mysql/mysql.h>
 
 #include "defines.h"
 
 #define MAX_QUERY_LEN 512
 
+struct DatabaseConnection;
+class DatabasePool;
+
 // connect to database, set query, escape query + execute query
 struct DatabaseField
 {
-    DatabaseField(){}
-    ~DatabaseField(){}
-
-    Wt::WString value;
-
-    Wt::WString GetWString();
-    const char * GetCString();
-    std::string GetString();
-    uint64 GetUInt64();
-    uint32 GetUInt32();
-    int GetInt();
-    bool GetBool();
+    DatabaseField() : data(NULL), length(0), null(true) {}
+
+    const char * data;                                  /// value inside result buffer (always NUL terminated), valid until result is cleared
+    uint32 length;                                      /// value length in bytes
+    bool null;                                          /// value is NULL in db
+
+    bool IsNull() const { return null; }               /// value is NULL in db
+    bool IsEmpty() const { return length == 0; }        /// value is NULL or empty string
+    uint32 GetLength() const { return length; }         /// value length in bytes (without NUL)
+    const char * GetData() const { return data; }       /// raw value bytes, NULL for NULL value
+
+    Wt::WString GetWString() const;                     /// converts value to WString on each call
+    const char * GetCString() const;                    /// returns value or empty string for NULL, pointer is valid until result is cleared
+    std::string GetString() const;
+    uint64 GetUInt64() const;                           /// parses decimal value without allocations, 0 for NULL or invalid value
+    uint32 GetUInt32() const;
+    int GetInt() const;
+    bool GetBool() const;
 };
 
+// view on fields of one row stored in DatabaseResult
 struct DatabaseRow
 {
-    DatabaseRow(MYSQL_ROW row, int count);
-    ~DatabaseRow();
+    DatabaseRow() : fields(NULL), count(0) {}
 
     DatabaseField * fields;
     int count;
 };
 
+/********************************************//**
+ * \brief Query result stored in contiguous memory.
+ *
+ * Values of all cells are copied into one buffer, fields
+ * and rows are kept in vectors so access to any row
+ * is O(1) and there is no allocation per row or cell.
+ * Field pointers are resolved lazily after rows were added
+ * because buffer can be reallocated while it grows.
+ *
+ ***********************************************/
+
+class DatabaseResult
+{
+public:
+    DatabaseResult() : resolved(true) {}
+    DatabaseResult(const DatabaseResult & result);
+    DatabaseResult & operator=(const DatabaseResult & result);
+
+    void Clear();                                       /// removes all rows (allocated memory is kept for next query)
+    void Reserve(uint32 rowsCount, int count);          /// reserves space for given rows count with given fields count
+    void AddRow(MYSQL_ROW row, int count, unsigned long * lengths = NULL); /// copies row into result, lengths can be NULL for text values
+
+    uint32 GetRowsCount() const { return rows.size(); }
+    DatabaseRow * GetRow(uint32 index);                 /// returns row from given index or NULL
+    const std::vector<DatabaseRow> & GetRows();         /// returns all rows
+
+private:
+    void Resolve();                                     /// sets fields and rows pointers after buffer changes
+
+    std::vector<char> buffer;                           /// values of all cells
+    std::vector<DatabaseField> fields;                  /// fields of all rows
+    std::vector<size_t> offsets;                        /// offsets of fields values in buffer
+    std::vector<DatabaseRow> rows;                      /// rows, each points to its first field
+    bool resolved;                                      /// pointers are valid
+};
+
+class Database;
+
+/********************************************//**
+ * \brief Forward only cursor over unbuffered query result.
+ *
+ * Rows are read from server one by one (mysql_use_result)
+ * and only current row is kept in memory, so it should be used
+ * for big results which are processed row by row.
+ * While cursor is open, connection of its Database object is
+ * occupied - other queries on this object will fail until
+ * cursor is closed (or destroyed). Slow processing of rows also
+ * keeps the query running on server, so don't wait on anything
+ * between Next() calls.
+ *
+ ***********************************************/
+
+class DatabaseCursor
+{
+public:
+    DatabaseCursor() : db(NULL), res(NULL), count(0), readCount(0), error(false) {}
+    ~DatabaseCursor() { Close(); }
+
+    bool Next();                                        /// reads next row, returns false when there are no more rows or error occurred
+    DatabaseRow * GetRow() { return current.GetRow(0); } /// returns current row, valid until next Next() call
+    void Close();                                       /// frees result (remaining rows are discarded) and unlocks connection
+
+    bool IsOpen() const { return res != NULL; }
+    bool HasError() const { return error; }             /// error occurred while reading rows
+    int GetFieldsCount() const { return count; }
+    uint32 GetReadCount() const { return readCount; }   /// rows read so far
+
+private:
+    friend class Database;
+
+    Database * db;                                      /// database which connection is occupied by cursor
+    MYSQL_RES * res;                                    /// unbuffered result
+    int count;                                          /// fields count
+    uint32 readCount;
+    bool error;
+    DatabaseResult current;                             /// current row, memory is reused by next rows
+};
+
+enum DatabaseParamType
+{
+    DB_PARAM_UINT32     = 0,
+    DB_PARAM_UINT64,
+    DB_PARAM_INT32,
+    DB_PARAM_STRING
+};
+
+struct DatabaseParam
+{
+    DatabaseParam() : type(DB_PARAM_UINT32), uint32Value(0), uint64Value(0), int32Value(0) {}
+
+    DatabaseParamType type;
+    uint32 uint32Value;
+    uint64 uint64Value;
+    int32 int32Value;
+    std::string stringValue;
+};
+
+// typed parameters for prepared statements, order must be same as '?' order in statement
+class DatabaseParams
+{
+public:
+    DatabaseParams() {}
+
+    DatabaseParams & AddUInt32(uint32 value);
+    DatabaseParams & AddUInt64(uint64 value);
+    DatabaseParams & AddInt32(int32 value);
+    DatabaseParams & AddString(const char * value);
+    DatabaseParams & AddString(const std::string & value);
+    DatabaseParams & AddWString(const Wt::WString & value);
+
+    size_t GetCount() const { return params.size(); }
+    void Bind(MYSQL_BIND * binds) const;                /// fills given binds array (must have GetCount() elements)
+
+private:
+    std::vector<DatabaseParam> params;
+};
+
 class Database
 {
 public:
@@ -65,8 +193,9 @@ public:
     void SetQuery(const std::string & query);           /// set query to execute
     bool SetPQuery(const char *format, ...);            /// set query to execute
 
-    bool Connect(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db); // connects to db
-    void Disconnect();
+    bool Connect(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int poolSize = 0); // borrows connection to db from pool
+    bool Connect(const DatabaseDsn & dsn) { return Connect(dsn.host, dsn.login, dsn.password, dsn.port, dsn.name, dsn.poolSize); }
+    void Disconnect();                                  /// returns connection to pool
     bool SelectDatabase(const std::string & db);
 
     std::string EscapeString(const char * str);         /// escape given string
@@ -77,25 +206,46 @@ public:
     int ExecuteQuery(const std::string & query);        /// execute given query and return row count
     int ExecutePQuery(const char * format, ...);
 
+    bool ExecuteStreamQuery(DatabaseCursor & cursor);   /// execute setted query without storing result, rows are read by cursor
+    bool ExecuteStreamQuery(const std::string & query, DatabaseCursor & cursor); /// execute given query without storing result, rows are read by cursor
+
+    int ExecuteBatch(const std::vector<std::string> & queries); /// execute all queries in one round trip, returns count of executed queries
+    uint32 GetBatchResultsCount() { return batchResults.size(); } /// returns count of results from last batch
+    DatabaseResult * GetBatchResult(uint32 index);      /// returns result of query with given index from last batch
+
+    int ExecuteStatement(const char * sql);             /// execute prepared statement without params and return row count
+    int ExecuteStatement(const char * sql, const DatabaseParams & params); /// execute prepared statement with given params and return row count
+
     const char * GetError();                            /// get mysql error
     unsigned int GetErrNo();                            /// get mysql error number
 
-    void AddRow(MYSQL_ROW row, int count);              /// add new row
+    void AddRow(MYSQL_ROW row, int count, unsigned long * lengths = NULL); /// add new row
 
     void Clear();                                       /// clear (+ delete from memory) result
 
-    int GetRowsCount() { return rows.size(); }          /// return rows count
+    int GetRowsCount() { return result.GetRowsCount(); } /// return rows count
     DatabaseRow * GetRow(uint32 index);                 /// returns row from given index
     DatabaseRow * GetRow();                             /// returns first row
-    std::list<DatabaseRow*> GetRows();                  /// returns all rows
+    const std::vector<DatabaseRow> & GetRows();         /// returns all rows (valid until next query or Clear)
+    const DatabaseResult & GetResult() const { return result; } /// returns whole result (copy it to keep rows after next query)
     std::string GetQuery() { return actualQuery; }      /// returns actual query
 
     void SetLogging(bool enabled) { loggingEnabled = enabled; }
 
 private:
-    MYSQL * connection;                                 /// mysql connection
+    friend class DatabaseCursor;
+
+    bool IsStreaming();                                 /// checks (and logs) if connection is occupied by cursor
+
+    MYSQL_STMT * GetStatement(const char * sql);       /// returns statement from connection cache (prepares it if needed)
+    void DropStatement(const char * sql);               /// removes broken statement from connection cache
+
+    DatabaseConnection * connection;                    /// pooled mysql connection
+    std::shared_ptr<DatabasePool> pool;                 /// pool from which connection was borrowed (kept alive until connection is returned)
     std::string actualQuery;                            /// actual query
-    std::list<DatabaseRow*> rows;                       /// query result
+    DatabaseResult result;                              /// query result
+    std::vector<DatabaseResult> batchResults;           /// results of last batch, one for each query
+    DatabaseCursor * cursor;                            /// open cursor which occupies connection
 
     bool loggingEnabled;                                /// queries should be logged ?
 };
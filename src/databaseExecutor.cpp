@@ -0,0 +1,270 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "databaseExecutor.h"
+
+#include <exception>
+
+#include <Wt/WApplication>
+#include <Wt/WServer>
+
+#include "activityLog.h"
+#include "config.h"
+#include "misc.h"
+
+DatabaseExecutor::DatabaseExecutor()
+    : stopping(false), maxQueueDepth(0), started(0), executed(0), rejected(0), totalWaitTime(0), maxWaitTime(0)
+{
+    int threads = sConfig.GetConfig(CONFIG_DB_EXECUTOR_THREADS);
+    if (threads < 1)
+        threads = 1;
+
+    maxQueueSize = sConfig.GetConfig(CONFIG_DB_EXECUTOR_QUEUE_SIZE) > 0 ? sConfig.GetConfig(CONFIG_DB_EXECUTOR_QUEUE_SIZE) : 1;
+
+    statsInterval = sConfig.GetConfig(CONFIG_OPTIONS_STATS_INTERVAL) > 0 ? sConfig.GetConfig(CONFIG_OPTIONS_STATS_INTERVAL) : 0;
+    nextStatsTime = std::chrono::steady_clock::now() + std::chrono::seconds(statsInterval);
+
+    for (int i = 0; i < threads; ++i)
+        workers.push_back(std::thread(&DatabaseExecutor::Run, this));
+}
+
+DatabaseExecutor::~DatabaseExecutor()
+{
+    Stop();
+}
+
+DatabaseExecutor & DatabaseExecutor::Instance()
+{
+    // same as in Config::Instance()
+    if (_executor == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_executor == nullptr)
+            _executor = new DatabaseExecutor();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<DatabaseExecutor*>(_executor);
+}
+
+void DatabaseExecutor::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(_createMutex);
+
+    if (_executor != nullptr)
+        const_cast<DatabaseExecutor*>(_executor)->Stop();
+}
+
+void DatabaseExecutor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+
+    queueCondition.notify_all();
+
+    // queued work is finished before threads stop
+    for (std::vector<std::thread>::iterator itr = workers.begin(); itr != workers.end(); ++itr)
+        if (itr->joinable())
+            itr->join();
+
+    workers.clear();
+}
+
+bool DatabaseExecutor::Post(const Task & work, const Task & completion)
+{
+    Wt::WApplication * app = Wt::WApplication::instance();
+
+    if (!app)
+    {
+        Misc::Console(DEBUG_DB, "%s: called outside of session\n", __FUNCTION__);
+        return false;
+    }
+
+    return Post(app->sessionId(), work, completion);
+}
+
+bool DatabaseExecutor::Post(const std::string & sessionId, const Task & work, const Task & completion)
+{
+    QueuedTask task;
+    task.work = work;
+    task.completion = completion;
+    task.sessionId = sessionId;
+    task.queueTime = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        if (stopping || queue.size() >= maxQueueSize)
+        {
+            ++rejected;
+            Misc::Log(LOG_DB_ERRORS, "DB executor queue is full (%u tasks), task rejected", uint32(queue.size()));
+            return false;
+        }
+
+        queue.push_back(task);
+
+        if (queue.size() > maxQueueDepth)
+            maxQueueDepth = queue.size();
+    }
+
+    queueCondition.notify_one();
+
+    return true;
+}
+
+void DatabaseExecutor::Run()
+{
+    while (true)
+    {
+        QueuedTask task;
+        bool hasTask = false;
+        bool logStats = false;
+
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+
+            // idle thread wakes up also when statistics should be logged
+            while (!stopping && queue.empty() && !IsStatsTime())
+            {
+                if (statsInterval)
+                    queueCondition.wait_until(lock, nextStatsTime);
+                else
+                    queueCondition.wait(lock);
+            }
+
+            if (IsStatsTime())
+            {
+                nextStatsTime = std::chrono::steady_clock::now() + std::chrono::seconds(statsInterval);
+                logStats = true;
+            }
+
+            if (!queue.empty())
+            {
+                task = queue.front();
+                queue.pop_front();
+                hasTask = true;
+
+                uint32 waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - task.queueTime).count();
+
+                ++started;
+                totalWaitTime += waitTime;
+                if (waitTime > maxWaitTime)
+                    maxWaitTime = waitTime;
+            }
+            else if (stopping)
+                return;
+        }
+
+        // getters lock queue again
+        if (logStats)
+            LogStats();
+
+        if (!hasTask)
+            continue;
+
+        try
+        {
+            if (task.work)
+                task.work();
+        }
+        catch (std::exception & e)
+        {
+            Misc::Log(LOG_DB_ERRORS, "DB executor task failed: %s", e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            ++executed;
+        }
+
+        if (!task.completion)
+            continue;
+
+        Wt::WServer * server = Wt::WServer::instance();
+
+        if (!server)
+            continue;
+
+        Task completion = task.completion;
+
+        // session could be already closed - then post does nothing
+        server->post(task.sessionId, [completion]()
+        {
+            completion();
+
+            if (Wt::WApplication * app = Wt::WApplication::instance())
+                app->triggerUpdate();
+        });
+    }
+}
+
+uint32 DatabaseExecutor::GetQueueDepth()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.size();
+}
+
+uint32 DatabaseExecutor::GetMaxQueueDepth()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return maxQueueDepth;
+}
+
+uint64 DatabaseExecutor::GetExecutedCount()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return executed;
+}
+
+uint64 DatabaseExecutor::GetRejectedCount()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return rejected;
+}
+
+uint32 DatabaseExecutor::GetAverageWaitTime()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return started ? totalWaitTime / started : 0;
+}
+
+uint32 DatabaseExecutor::GetMaxWaitTime()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return maxWaitTime;
+}
+
+bool DatabaseExecutor::IsStatsTime() const
+{
+    return statsInterval && std::chrono::steady_clock::now() >= nextStatsTime;
+}
+
+void DatabaseExecutor::LogStats()
+{
+    Misc::Log(LOG_STATS, "DB executor: queue %u (max %u), executed %llu, rejected %llu, wait time avg %u ms (max %u ms)", GetQueueDepth(), GetMaxQueueDepth(),
+              (unsigned long long)GetExecutedCount(), (unsigned long long)GetRejectedCount(), GetAverageWaitTime(), GetMaxWaitTime());
+
+    Misc::Log(LOG_STATS, "Activity log: pending %u, written %llu, dropped %llu, failed %llu", sActivityLog.GetPendingCount(),
+              (unsigned long long)sActivityLog.GetWrittenCount(), (unsigned long long)sActivityLog.GetDroppedCount(), (unsigned long long)sActivityLog.GetFailedCount());
+}
+
+volatile DatabaseExecutor * DatabaseExecutor::_executor = nullptr;
+std::mutex DatabaseExecutor::_createMutex;
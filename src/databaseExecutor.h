@@ -0,0 +1,106 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATABASE_EXECUTOR_H_INCLUDED
+#define DATABASE_EXECUTOR_H_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+
+/********************************************//**
+ * \brief Executes database work outside of Wt event loop.
+ *
+ * Work is queued and executed by one of executor threads,
+ * after that completion is posted to session which queued
+ * the work (WServer::post) so it can safely update widgets.
+ * Work must not touch widgets or session objects - it should
+ * only fill data captured by both functions.
+ * Completion isn't called when session was closed meanwhile.
+ * Queue statistics (with activity log counters) are logged
+ * periodically (LOG_STATS) by one of idle or finishing threads.
+ *
+ ***********************************************/
+
+class DatabaseExecutor
+{
+public:
+    typedef std::function<void ()> Task;
+
+    static DatabaseExecutor & Instance();
+    static void Shutdown();                             /// stops executor threads (if executor was created)
+
+    bool Post(const Task & work, const Task & completion); /// queues work for current session, returns false when queue is full
+    bool Post(const std::string & sessionId, const Task & work, const Task & completion); /// queues work for given session, returns false when queue is full
+
+    uint32 GetQueueDepth();                             /// returns count of waiting tasks
+    uint32 GetMaxQueueDepth();                          /// returns highest count of waiting tasks
+    uint64 GetExecutedCount();                          /// returns count of executed tasks
+    uint64 GetRejectedCount();                          /// returns count of tasks rejected because of full queue
+    uint32 GetAverageWaitTime();                        /// returns average time (ms) spent by tasks in queue
+    uint32 GetMaxWaitTime();                            /// returns longest time (ms) spent by task in queue
+
+private:
+    DatabaseExecutor();
+    DatabaseExecutor(const DatabaseExecutor &) {}
+    ~DatabaseExecutor();
+
+    struct QueuedTask
+    {
+        Task work;
+        Task completion;
+        std::string sessionId;
+        std::chrono::steady_clock::time_point queueTime;
+    };
+
+    void Run();                                         /// executor thread loop
+    void Stop();
+    bool IsStatsTime() const;                           /// statistics should be logged, should be called with locked queueMutex
+    void LogStats();
+
+    std::vector<std::thread> workers;
+    std::deque<QueuedTask> queue;
+    uint32 maxQueueSize;
+    bool stopping;
+
+    uint32 maxQueueDepth;
+    uint64 started;                                     /// tasks taken from queue (for average wait time)
+    uint64 executed;
+    uint64 rejected;
+    uint64 totalWaitTime;
+    uint32 maxWaitTime;
+
+    int statsInterval;                                  /// seconds between statistics logs, 0 - never
+    std::chrono::steady_clock::time_point nextStatsTime;
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+
+    static volatile DatabaseExecutor * _executor;
+    static std::mutex _createMutex;
+};
+
+#define sDatabaseExecutor DatabaseExecutor::Instance()
+
+#endif // DATABASE_EXECUTOR_H_INCLUDED
@@ -0,0 +1,304 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "databasePool.h"
+
+#include <chrono>
+#include <set>
+#include <mysql/errmsg.h>
+
+#include "config.h"
+#include "misc.h"
+
+/// DatabasePool
+
+DatabasePool::DatabasePool(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int size)
+    : host(host), login(login), password(password), port(port), db(db), maxSize(size), busy(0)
+{
+    if (maxSize < 1)
+        maxSize = 1;
+}
+
+DatabasePool::~DatabasePool()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    for (std::list<DatabaseConnection*>::iterator itr = idle.begin(); itr != idle.end(); ++itr)
+        Close(*itr);
+
+    idle.clear();
+}
+
+DatabaseConnection * DatabasePool::Open()
+{
+    DatabaseConnection * conn = new DatabaseConnection();
+    conn->mysql = mysql_init(NULL);
+
+    if (!conn->mysql || !mysql_real_connect(conn->mysql, host.c_str(), login.c_str(), password.c_str(), db.c_str(), port, NULL, 0))
+    {
+        Misc::Console(DEBUG_DB, "%s: Can't connect to db ! Data: host (%s) login (%s) port(%i) db(%s)\n",
+                        __FUNCTION__, host.c_str(), login.c_str(), port, db.c_str());
+        Close(conn);
+        return NULL;
+    }
+
+    return conn;
+}
+
+void DatabasePool::Close(DatabaseConnection * conn)
+{
+    if (!conn)
+        return;
+
+    for (std::map<std::string, MYSQL_STMT*>::iterator itr = conn->statements.begin(); itr != conn->statements.end(); ++itr)
+        mysql_stmt_close(itr->second);
+
+    conn->statements.clear();
+
+    if (conn->mysql)
+        mysql_close(conn->mysql);
+
+    delete conn;
+}
+
+void DatabasePool::EvictIdle(std::time_t now)
+{
+    std::time_t idleTimeout = sConfig.GetConfig(CONFIG_DB_POOL_IDLE_TIMEOUT);
+
+    if (idleTimeout <= 0)
+        return;
+
+    // least recently used connections are at the end of list
+    while (!idle.empty() && idle.back()->lastUsed + idleTimeout < now)
+    {
+        Close(idle.back());
+        idle.pop_back();
+    }
+}
+
+DatabaseConnection * DatabasePool::Acquire()
+{
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    std::chrono::steady_clock::time_point waitUntil = std::chrono::steady_clock::now() + std::chrono::seconds(sConfig.GetConfig(CONFIG_DB_POOL_WAIT_TIMEOUT));
+
+    while (true)
+    {
+        std::time_t now = std::time(NULL);
+
+        EvictIdle(now);
+
+        if (!idle.empty())
+        {
+            DatabaseConnection * conn = idle.front();
+            idle.pop_front();
+            ++busy;
+
+            bool needPing = conn->lastUsed + sConfig.GetConfig(CONFIG_DB_POOL_PING_INTERVAL) <= now;
+
+            // ping can take a while so don't block other threads
+            lock.unlock();
+
+            if (!needPing || mysql_ping(conn->mysql) == 0)
+                return conn;
+
+            Misc::Console(DEBUG_DB, "%s: dropping dead connection to db(%s) on host(%s)\n", __FUNCTION__, db.c_str(), host.c_str());
+            Close(conn);
+
+            lock.lock();
+            --busy;
+            continue;
+        }
+
+        if (busy < maxSize)
+        {
+            ++busy;
+            lock.unlock();
+
+            DatabaseConnection * conn = Open();
+
+            if (!conn)
+            {
+                lock.lock();
+                --busy;
+                poolCondition.notify_one();
+            }
+
+            return conn;
+        }
+
+        if (poolCondition.wait_until(lock, waitUntil) == std::cv_status::timeout && idle.empty() && busy >= maxSize)
+        {
+            Misc::Console(DEBUG_DB, "%s: no free connection to db(%s) on host(%s) (busy: %i)\n", __FUNCTION__, db.c_str(), host.c_str(), busy);
+            return NULL;
+        }
+    }
+}
+
+void DatabasePool::Release(DatabaseConnection * conn)
+{
+    if (!conn)
+        return;
+
+    unsigned int errNo = mysql_errno(conn->mysql);
+    bool broken = conn->dirty || errNo == CR_SERVER_GONE_ERROR || errNo == CR_SERVER_LOST;
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+
+    --busy;
+
+    if (broken || busy + int(idle.size()) >= maxSize)
+    {
+        lock.unlock();
+        Close(conn);
+        lock.lock();
+    }
+    else
+    {
+        conn->lastUsed = std::time(NULL);
+        idle.push_front(conn);
+        EvictIdle(conn->lastUsed);
+    }
+
+    poolCondition.notify_one();
+}
+
+void DatabasePool::SetMaxSize(int size)
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+
+    maxSize = size < 1 ? 1 : size;
+
+    // surplus busy connections will be closed on release
+    while (!idle.empty() && busy + int(idle.size()) > maxSize)
+    {
+        Close(idle.back());
+        idle.pop_back();
+    }
+
+    poolCondition.notify_all();
+}
+
+int DatabasePool::GetMaxSize()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return maxSize;
+}
+
+int DatabasePool::GetIdleCount()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return idle.size();
+}
+
+int DatabasePool::GetBusyCount()
+{
+    std::lock_guard<std::mutex> lock(poolMutex);
+    return busy;
+}
+
+/// DatabasePoolMgr
+
+DatabasePoolMgr::DatabasePoolMgr()
+{
+    // mysql_init calls it implicitly but it's not thread safe
+    mysql_library_init(0, NULL, NULL);
+}
+
+DatabasePoolMgr::~DatabasePoolMgr()
+{
+    pools.clear();
+}
+
+DatabasePoolMgr & DatabasePoolMgr::Instance()
+{
+    // same as in Config::Instance()
+    if (_poolMgr == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_poolMgr == nullptr)
+            _poolMgr = new DatabasePoolMgr();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<DatabasePoolMgr*>(_poolMgr);
+}
+
+std::string DatabasePoolMgr::GetKey(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db)
+{
+    // password is also part of key so changed credentials will get new pool
+    return Misc::GetFormattedString("%s:%u:", host.c_str(), port) + login + ":" + db + ":" + password;
+}
+
+std::shared_ptr<DatabasePool> DatabasePoolMgr::GetPool(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int size)
+{
+    if (size <= 0)
+        size = sConfig.GetConfig(CONFIG_DB_POOL_SIZE);
+
+    std::string key = GetKey(host, login, password, port, db);
+
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    std::map<std::string, std::shared_ptr<DatabasePool> >::iterator itr = pools.find(key);
+    if (itr != pools.end())
+    {
+        // pool size could be changed by config reload
+        if (itr->second->GetMaxSize() != (size < 1 ? 1 : size))
+            itr->second->SetMaxSize(size);
+
+        return itr->second;
+    }
+
+    std::shared_ptr<DatabasePool> pool(new DatabasePool(host, login, password, port, db, size));
+    pools[key] = pool;
+
+    return pool;
+}
+
+void DatabasePoolMgr::PrunePools(const ConfigData & config)
+{
+    std::set<std::string> keys;
+    DatabaseDsn dsn;
+
+    dsn = config.GetAccountsDsn();
+    keys.insert(GetKey(dsn.host, dsn.login, dsn.password, dsn.port, dsn.name));
+
+    dsn = config.GetPanelDsn();
+    keys.insert(GetKey(dsn.host, dsn.login, dsn.password, dsn.port, dsn.name));
+
+    for (int i = 0; i < config.GetConfig(CONFIG_REALMS_COUNT); ++i)
+    {
+        dsn = config.GetRealmDsn(i);
+        keys.insert(GetKey(dsn.host, dsn.login, dsn.password, dsn.port, dsn.name));
+    }
+
+    std::lock_guard<std::mutex> lock(poolsMutex);
+
+    // Database objects still connected to removed pool keep it alive until disconnect
+    for (std::map<std::string, std::shared_ptr<DatabasePool> >::iterator itr = pools.begin(); itr != pools.end();)
+    {
+        if (keys.find(itr->first) == keys.end())
+            pools.erase(itr++);
+        else
+            ++itr;
+    }
+}
+
+volatile DatabasePoolMgr * DatabasePoolMgr::_poolMgr = nullptr;
+std::mutex DatabasePoolMgr::_createMutex;
@@ -0,0 +1,134 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATABASE_POOL_H_INCLUDED
+#define DATABASE_POOL_H_INCLUDED
+
+#ifdef WIN32
+#include <winsock2.h>
+#endif
+
+#include <condition_variable>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <mysql/mysql.h>
+
+#include "defines.h"
+
+/********************************************//**
+ * \brief Single MySQL connection owned by pool.
+ *
+ * Connection is borrowed by Database object on Connect
+ * and returned to its pool on Disconnect.
+ * Prepared statements live as long as connection so they
+ * are cached here by their SQL text.
+ *
+ ***********************************************/
+
+struct DatabaseConnection
+{
+    DatabaseConnection() : mysql(NULL), lastUsed(0), dirty(false) {}
+
+    MYSQL * mysql;              /// mysql handle
+    std::time_t lastUsed;       /// time when connection was returned to pool
+    bool dirty;                 /// connection state was changed (for example other db selected) - it shouldn't be reused
+
+    std::map<std::string, MYSQL_STMT*> statements;  /// prepared statements cache
+};
+
+/********************************************//**
+ * \brief Pool of connections for one DSN.
+ *
+ * Idle connections are kept on list (most recently used first),
+ * pinged before reuse when they were idle for too long and closed
+ * when they weren't used for configured time.
+ *
+ ***********************************************/
+
+class DatabasePool
+{
+public:
+    DatabasePool(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int size);
+    ~DatabasePool();
+
+    DatabaseConnection * Acquire();                     /// borrow connection, returns NULL when there is no free connection and new one can't be created
+    void Release(DatabaseConnection * conn);            /// return borrowed connection to pool
+
+    void SetMaxSize(int size);                          /// changes max connections count
+    int GetMaxSize();                                   /// returns max connections count
+
+    int GetIdleCount();                                 /// returns idle connections count
+    int GetBusyCount();                                 /// returns borrowed connections count
+
+private:
+    DatabaseConnection * Open();                        /// creates new connection
+    void Close(DatabaseConnection * conn);              /// closes and deletes connection
+    void EvictIdle(std::time_t now);                    /// closes connections idle for too long, should be called with locked poolMutex
+
+    std::string host;
+    std::string login;
+    std::string password;
+    unsigned int port;
+    std::string db;
+
+    int maxSize;                                        /// max connections (idle + busy) count
+    int busy;                                           /// borrowed connections count
+    std::list<DatabaseConnection*> idle;                /// idle connections, most recently used first
+
+    std::mutex poolMutex;
+    std::condition_variable poolCondition;
+};
+
+class ConfigData;
+
+/********************************************//**
+ * \brief Process wide pools registry.
+ *
+ * Each DSN (host, port, login, db) has its own pool which is created on first use.
+ * After config reload pools of DSNs which aren't in new config are removed,
+ * pool is deleted (with its idle connections) when last borrowed connection is returned.
+ *
+ ***********************************************/
+
+class DatabasePoolMgr
+{
+public:
+    static DatabasePoolMgr & Instance();
+
+    std::shared_ptr<DatabasePool> GetPool(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db, int size);
+    void PrunePools(const ConfigData & config);         /// removes pools of DSNs which aren't used by given config
+
+private:
+    DatabasePoolMgr();
+    DatabasePoolMgr(const DatabasePoolMgr &) {}
+    ~DatabasePoolMgr();
+
+    static std::string GetKey(const std::string & host, const std::string & login, const std::string & password, unsigned int port, const std::string & db);
+
+    std::map<std::string, std::shared_ptr<DatabasePool> > pools;
+    std::mutex poolsMutex;
+
+    static volatile DatabasePoolMgr * _poolMgr;
+    static std::mutex _createMutex;
+};
+
+#define sDatabasePoolMgr DatabasePoolMgr::Instance()
+
+#endif // DATABASE_POOL_H_INCLUDED
@@ -31,6 +31,8 @@
 #define DEFINES_H_INCLUDED
 
 #include <cstdio>
+#include <ctime>
+#include <memory>
 
 #ifdef DEBUG
 #include <iostream>
@@ -283,7 +285,9 @@ enum Expansion
     EXPANSION_PRETBC    = 0,    /**< Vanilla WoW (pre TBC, without expansion) */
     EXPANSION_TBC       = 1,    /**< The Burning Crusade expansion */
     EXPANSION_WOTLK     = 2,    /**< Wrath of the Lich King expansion */
-    EXPANSION_CATA      = 3     /**< Cataclysm expansion */
+    EXPANSION_CATA      = 3,    /**< Cataclysm expansion */
+
+    MAX_EXPANSIONS              /**< Expansions count - size of tables indexed by expansion */
 };
 
 /********************************************//**
@@ -471,6 +475,8 @@ enum MenuOptions
 #define TXT_STATUS_REV                  "status.revision"           /**< Realm revision label. */
 #define TXT_STATUS_DIFF                 "status.diff"               /**< Realm diff label. */
 #define TXT_STATUS_AVGDIFF              "status.diff.avarage"       /**< Realm avarage diff label. */
+#define TXT_STATUS_HISTORY_DAY          "status.history.day"        /**< Online players from last 24 hours label. */
+#define TXT_STATUS_HISTORY_MONTH        "status.history.month"      /**< Online players from last 30 days label. */
 
 /** Buttons */
 #define TXT_BTN_PASS_CHANGE             "button.password.change"    /**< Password change button label */
@@ -654,9 +660,10 @@ enum LogFlags
     LOG_DB_ERRORS       = 0x02,     /**< Log flag for logging DB query errors */
     LOG_INVALID_DATA    = 0x04,     /**< Log flag for logging validation errors */
     LOG_STRANGE_DATA    = 0x08,     /**< Log flag for logging errors probably caused by strange data received from user */
+    LOG_STATS           = 0x10,     /**< Log flag for logging periodic statistics of background workers */
 
     LOG_DB  = LOG_DB_QUERY | LOG_DB_ERRORS,
-    LOG_ALL = LOG_DB | LOG_INVALID_DATA | LOG_STRANGE_DATA,
+    LOG_ALL = LOG_DB | LOG_INVALID_DATA | LOG_STRANGE_DATA | LOG_STATS,
 };
 
 /********************************************//**
@@ -700,7 +707,9 @@ enum CharacterRaces
     RACE_GNOME      = 7,    /**< Character race: Gnome */
     RACE_TROLL      = 8,    /**< Character race: Troll */
     RACE_BLOOD_ELF  = 10,   /**< Character race: Blood elf */
-    RACE_DRAENEI    = 11    /**< Character race: Draenei */
+    RACE_DRAENEI    = 11,   /**< Character race: Draenei */
+
+    MAX_RACES               /**< Highest race + 1 - size of tables indexed by race */
 };
 
 /********************************************//**
@@ -718,7 +727,9 @@ enum CharacterClasses
     CLASS_SHAMAN        = 7,    /**< Character class: Shaman */
     CLASS_MAGE          = 8,    /**< Character class: Mage */
     CLASS_WARLOCK       = 9,    /**< Character class: Warlock */
-    CLASS_DRUID         = 11    /**< Character class: Druid */
+    CLASS_DRUID         = 11,   /**< Character class: Druid */
+
+    MAX_CLASSES                 /**< Highest class + 1 - size of tables indexed by class */
 };
 
 /********************************************//**
@@ -734,28 +745,6 @@ enum ConflictSide
     SIDE_UNKNOWN    = 5     /**< Unknown conflict side */
 };
 
-/********************************************//**
- * \brief Represents single spell informations.
- ***********************************************/
-
-struct SpellInfo
-{
-    SpellInfo():
-        entry(0), name("")
-    {
-
-    }
-
-    SpellInfo(uint32 entry, WString name) :
-        entry(entry), name(name)
-    {
-
-    }
-
-    uint32 entry;
-    WString name;
-};
-
 /********************************************//**
  * \brief Enum for realm informations
  ***********************************************/
@@ -771,6 +760,7 @@ enum RealmInfo
     REALM_INFO_DB_PASSWORD  = 6,    /**< Password to realm database */
     REALM_INFO_DB_PORT      = 7,    /**< Port to realm database */
     REALM_INFO_DB_NAME      = 8,    /**< Name of realm database */
+    REALM_INFO_DB_POOL_SIZE = 9,    /**< Max connections count in realm database pool */
 
     REALM_INFO_COUNT
 };
@@ -779,14 +769,14 @@ struct RealmInformations
 {
     RealmInformations()
         : name(""), statusUrl(""), additionalInfo(""), realmId(0),
-            dbHost(""), dbLogin(""), dbPass(""), dbPort(0), dbName("")
+            dbHost(""), dbLogin(""), dbPass(""), dbPort(0), dbName(""), dbPoolSize(0)
     {
 
     }
 
     RealmInformations(const RealmInformations & p)
         : name(p.name), statusUrl(p.statusUrl), additionalInfo(p.additionalInfo), realmId(p.realmId),
-            dbHost(p.dbHost), dbLogin(p.dbLogin), dbPass(p.dbPass), dbPort(p.dbPort), dbName(p.dbName)
+            dbHost(p.dbHost), dbLogin(p.dbLogin), dbPass(p.dbPass), dbPort(p.dbPort), dbName(p.dbName), dbPoolSize(p.dbPoolSize)
     {
 
     }
@@ -800,6 +790,27 @@ struct RealmInformations
     std::string dbPass;
     int dbPort;
     std::string dbName;
+    int dbPoolSize;
+};
+
+/********************************************//**
+ * \brief Connection data of one database.
+ *
+ * All fields are taken from one config snapshot,
+ * so config reload can't mix values of two configs.
+ *
+ ***********************************************/
+
+struct DatabaseDsn
+{
+    DatabaseDsn() : port(0), poolSize(0) {}
+
+    std::string host;
+    std::string login;
+    std::string password;
+    int port;
+    std::string name;
+    int poolSize;
 };
 
 // enums/defines from core:
@@ -906,27 +917,38 @@ struct Item
     uint32 stackCount;
 };
 
+struct TemplateSegments;
+typedef std::shared_ptr<const TemplateSegments> TemplateSegmentsPtr;
+typedef std::shared_ptr<const std::string> TemplateTextPtr;
+
 struct TemplateInfo
 {
-    TemplateInfo() : name(""), stylePath(""), tmpltPath(""), currentTemplate("") {}
+    TemplateInfo() : name(""), stylePath(""), tmpltPath(""), modificationTime(0) {}
     TemplateInfo(const char * name, const char * style, const char * tmplt)
-        : name(name), stylePath(style), tmpltPath(tmplt), currentTemplate("") {}
+        : name(name), stylePath(style), tmpltPath(tmplt), modificationTime(0) {}
 
-    std::string GetFullStylePath()
+    std::string GetFullStylePath() const
     {
         return stylePath + "/style.css";
     }
 
-    std::string GetFullTemplatePath()
+    std::string GetFullTemplatePath() const
     {
         return tmpltPath + "/" + name + ".tmplt";
     }
 
+    bool IsSame(const TemplateInfo & tmplt) const
+    {
+        return name == tmplt.name && stylePath == tmplt.stylePath && tmpltPath == tmplt.tmpltPath && modificationTime == tmplt.modificationTime;
+    }
+
     std::string name;
     std::string stylePath;
     std::string tmpltPath;
 
-    std::string currentTemplate;
+    TemplateTextPtr currentTemplate;        /// .tmplt file content shared by all sessions, NULL when file couldn't be read
+    TemplateSegmentsPtr compiledTemplate;   /// compiled currentTemplate, NULL when it couldn't be compiled
+    time_t modificationTime;                /// .tmplt file modification time
 };
 
 #define QUEST_TYPE_DAILY    87
@@ -0,0 +1,81 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemInstanceData.h"
+
+#include <cstring>
+
+#include "database.h"
+
+ItemInstanceData::ItemInstanceData(const char * data, uint32 length)
+: data(data), length(data ? length : 0), count(0)
+{
+    Tokenize();
+}
+
+ItemInstanceData::ItemInstanceData(const DatabaseField & field)
+: data(field.GetData()), length(field.GetLength()), count(0)
+{
+    Tokenize();
+}
+
+void ItemInstanceData::Tokenize()
+{
+    const char * pos = data;
+    const char * end = data + length;
+
+    // only fields used by panel are indexed, rest of data is skipped
+    while (pos < end && count < ITEM_DATA_FIELD_COUNT)
+    {
+        // values are separated by one space, but don't rely on it
+        if (*pos == ' ')
+        {
+            ++pos;
+            continue;
+        }
+
+        offsets[count++] = pos - data;
+
+        pos = (const char *)memchr(pos, ' ', end - pos);
+        if (!pos)
+            break;
+    }
+}
+
+uint32 ItemInstanceData::GetUInt32(uint32 field) const
+{
+    if (field >= count)
+        return 0;
+
+    const char * pos = data + offsets[field];
+    const char * end = data + length;
+
+    // values are stored as unsigned, so overflow is wrapped same as by core
+    uint32 value = 0;
+    for (; pos < end && *pos >= '0' && *pos <= '9'; ++pos)
+        value = value * 10 + uint32(*pos - '0');
+
+    return value;
+}
+
+uint32 ItemInstanceData::GetEnchantmentId(uint32 slot) const
+{
+    if (slot >= MAX_ITEM_ENCHANTMENT_SLOTS)
+        return 0;
+
+    return GetUInt32(ITEM_DATA_ENCHANTMENT + slot * 3);
+}
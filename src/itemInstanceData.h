@@ -0,0 +1,102 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEM_INSTANCE_DATA_H_INCLUDED
+#define ITEM_INSTANCE_DATA_H_INCLUDED
+
+#include "defines.h"
+
+struct DatabaseField;
+
+/********************************************//**
+ * \brief Fields of item_instance.data column.
+ *
+ * Values are indexes of item update fields (2.4.3 client).
+ *
+ ***********************************************/
+
+enum ItemInstanceField
+{
+    ITEM_DATA_GUID                  = 0,    /**< Item guid (2 fields). */
+    ITEM_DATA_ENTRY                 = 3,    /**< Item template id. */
+    ITEM_DATA_OWNER                 = 6,    /**< Owner guid (2 fields). */
+    ITEM_DATA_CONTAINED             = 8,    /**< Bag guid (2 fields). */
+    ITEM_DATA_CREATOR               = 10,   /**< Creator guid (2 fields). */
+    ITEM_DATA_GIFT_CREATOR          = 12,   /**< Gift creator guid (2 fields). */
+    ITEM_DATA_STACK_COUNT           = 14,   /**< Items count in stack. */
+    ITEM_DATA_DURATION              = 15,   /**< Remaining duration. */
+    ITEM_DATA_SPELL_CHARGES         = 16,   /**< Spell charges (5 fields). */
+    ITEM_DATA_FLAGS                 = 21,   /**< Item flags. */
+    ITEM_DATA_ENCHANTMENT           = 22,   /**< Enchantments (3 fields per slot: id, duration, charges). */
+    ITEM_DATA_PROPERTY_SEED         = 55,   /**< Random suffix factor. */
+    ITEM_DATA_RANDOM_PROPERTIES_ID  = 56,   /**< Random property (positive) or suffix (negative) id. */
+    ITEM_DATA_TEXT_ID               = 57,   /**< item_text id. */
+    ITEM_DATA_DURABILITY            = 58,   /**< Current durability. */
+    ITEM_DATA_MAX_DURABILITY        = 59,   /**< Max durability. */
+
+    ITEM_DATA_FIELD_COUNT           = 60
+};
+
+#define MAX_ITEM_ENCHANTMENT_SLOTS  11  /// enchantment slots stored in data (3 fields each)
+
+/********************************************//**
+ * \brief Read only view of item_instance.data value.
+ *
+ * Data is a list of decimal values separated by spaces.
+ * Previously stack count was cut out by MySQL
+ * (SUBSTRING_INDEX for every row), now raw data is
+ * read and fields are found here. Constructor
+ * finds start of each field once (spaces are found
+ * with memchr, which scans many bytes at once),
+ * so reading any field later doesn't scan data again.
+ *
+ * View doesn't copy data, so it's valid only until
+ * db result is cleared.
+ *
+ ***********************************************/
+
+class ItemInstanceData
+{
+public:
+    ItemInstanceData(const char * data, uint32 length);
+    explicit ItemInstanceData(const DatabaseField & field);
+
+    uint32 GetFieldCount() const { return count; }      /// count of fields found in data (max ITEM_DATA_FIELD_COUNT)
+
+    uint32 GetUInt32(uint32 field) const;               /// returns field value, 0 for missing or invalid field
+    int32 GetInt32(uint32 field) const { return int32(GetUInt32(field)); }
+
+    uint32 GetEntry() const { return GetUInt32(ITEM_DATA_ENTRY); }
+    uint32 GetStackCount() const { return GetUInt32(ITEM_DATA_STACK_COUNT); }
+    uint32 GetFlags() const { return GetUInt32(ITEM_DATA_FLAGS); }
+    uint32 GetDurability() const { return GetUInt32(ITEM_DATA_DURABILITY); }
+    uint32 GetMaxDurability() const { return GetUInt32(ITEM_DATA_MAX_DURABILITY); }
+    uint32 GetEnchantmentId(uint32 slot) const;         /// returns enchantment id from given slot, 0 for empty or invalid slot
+    int32 GetRandomPropertyId() const { return GetInt32(ITEM_DATA_RANDOM_PROPERTIES_ID); }
+    uint32 GetPropertySeed() const { return GetUInt32(ITEM_DATA_PROPERTY_SEED); }
+
+private:
+    void Tokenize();
+
+    const char * data;
+    uint32 length;
+
+    uint32 offsets[ITEM_DATA_FIELD_COUNT];              /// start of each field in data
+    uint32 count;
+};
+
+#endif // ITEM_INSTANCE_DATA_H_INCLUDED
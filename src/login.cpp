@@ -84,8 +84,7 @@ void LoginWidget::Login()
     }
 
     Database db;
-    if (!db.Connect(sConfig.GetConfig(CONFIG_DB_ACCOUNTS_HOST), sConfig.GetConfig(CONFIG_DB_ACCOUNTS_LOGIN),
-                    sConfig.GetConfig(CONFIG_DB_ACCOUNTS_PASSWORD), sConfig.GetConfig(CONFIG_DB_ACCOUNTS_PORT), sConfig.GetConfig(CONFIG_DB_ACCOUNTS_NAME)))
+    if (!db.Connect(DB_ACCOUNTS_DATA))
     {
         Misc::Error::ShowErrorBoxTr(TXT_GEN_ERROR, TXT_ERROR_DB_CANT_CONNECT);
         return;
@@ -95,23 +94,21 @@ void LoginWidget::Login()
     std::string escapedPass = db.EscapeString(password->text());
     WString shapass = Misc::Hash::PWGetSHA1("%s:%s", Misc::Hash::HASH_FLAG_UPPER, escapedLogin.c_str(), escapedPass.c_str());
 
-               //           0          1           2          3        4         5            6              7           8               9               10
-    db.SetPQuery("SELECT username, pass_hash, a.account_id, email, join_date, last_ip, account_state_id, expansion, account_flags, support_points, permission_mask "
-                 "FROM account AS a JOIN account_support AS as ON a.account_id = as.account_id JOIN account_permissions AS ap ON a.account_id = ap.account_id "
-                 "WHERE username = '%s' AND realm_id = '%i'", escapedLogin.c_str(), session->currentRealm);
-
     // execute will return 0 if result will be empty and -1 if there will be DB error.
-    switch (db.ExecuteQuery())
+                                    //     0          1           2          3        4         5            6              7           8               9               10
+    switch (db.ExecuteStatement("SELECT username, pass_hash, a.account_id, email, join_date, last_ip, account_state_id, expansion, account_flags, support_points, permission_mask "
+                                "FROM account AS a JOIN account_support AS as ON a.account_id = as.account_id JOIN account_permissions AS ap ON a.account_id = ap.account_id "
+                                "WHERE username = ? AND realm_id = ?", DatabaseParams().AddWString(login->text()).AddInt32(session->currentRealm)))
     {
         case DB_RESULT_ERROR:
         {
-            Misc::Account::AddActivity(escapedLogin, session->sessionIp.toUTF8(), TXT_ACT_LOGIN_FAIL, "");
+            Misc::Account::AddActivity(login->text().toUTF8(), session->sessionIp.toUTF8(), TXT_ACT_LOGIN_FAIL, "");
             Misc::Error::ShowErrorBoxTr(TXT_GEN_ERROR, TXT_ERROR_DB_QUERY_ERROR);
             return;
         }
         case DB_RESULT_EMPTY:
         {
-            Misc::Account::AddActivity(escapedLogin, session->sessionIp.toUTF8(), TXT_ACT_LOGIN_FAIL, "");
+            Misc::Account::AddActivity(login->text().toUTF8(), session->sessionIp.toUTF8(), TXT_ACT_LOGIN_FAIL, "");
             Misc::Error::ShowErrorBoxTr(TXT_GEN_ERROR, TXT_ERROR_WRONG_LOGIN_DATA);
             return;
         }
@@ -179,7 +176,8 @@ void LoginWidget::Login()
             session->supportPoints = row->fields[9].GetUInt32();
             session->permissions = row->fields[10].GetUInt64();
 
-            if (db.ExecutePQuery("SELECT 1 FROM account_punishment WHERE account_id = '%u' AND punishment_type_id = '%u' AND (punishment_date = expiration_date OR expiration_date > UNIX_TIMESTAMP())", session->accountId) > DB_RESULT_EMPTY)
+            if (db.ExecuteStatement("SELECT 1 FROM account_punishment WHERE account_id = ? AND punishment_type_id = ? AND (punishment_date = expiration_date OR expiration_date > UNIX_TIMESTAMP())",
+                                    DatabaseParams().AddUInt64(session->accountId).AddUInt32(PUNISHMENT_BAN)) > DB_RESULT_EMPTY)
                 session->banned = true;
 
             login->setText("");
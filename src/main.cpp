@@ -17,23 +17,34 @@
 
 #include "main.h"
 
+#include <iostream>
+
 #include <Wt/WEnvironment>
 #include <Wt/WImage>
 #include <Wt/WMenu>
 #include <Wt/WMenuItem>
 #include <Wt/WOverlayLoadingIndicator>
 #include <Wt/WPushButton>
+#include <Wt/WServer>
 #include <Wt/WStackedWidget>
 #include <Wt/WTable>
 #include <Wt/WText>
 #include <Wt/WTemplate>
 
+#include "activityLog.h"
+#include "compiledTemplate.h"
 #include "config.h"
 #include "database.h"
+#include "databaseExecutor.h"
 #include "menu.h"
+#include "messageStore.h"
 #include "misc.h"
 #include "LangsWidget.h"
 #include "login.h"
+#include "realmStatus.h"
+#include "spellDictionary.h"
+#include "statusResource.h"
+#include "templateRegistry.h"
 #include "TemplateWidget.h"
 
 PlayersPanel::PlayersPanel(const Wt::WEnvironment& env)
@@ -42,32 +53,26 @@ PlayersPanel::PlayersPanel(const Wt::WEnvironment& env)
     session = new SessionInfo();
     session->sessionIp = env.clientAddress();
 
+    // needed to show results of queries executed in background
+    enableUpdates(true);
+
     setLoadingIndicator(new Wt::WOverlayLoadingIndicator());
     loadingIndicator()->setMessage(Wt::WString::tr(TXT_GEN_LOADING));
-    messageResourceBundle().use("langs/panel");
+    // messages are loaded once in main(), session only resolves keys for its locale
+    setLocalizedStrings(new SessionMessages());
 
     setTitle(Wt::WString::tr(TXT_SITE_TITLE));
 
-    // template info - assign default paths for default template
-    TemplateInfo tmplt;
-
+    // template info - registry returns default template when there is no template with given name
     const std::string * cookieVal = env.getCookieValue("tmplt");
-    if (cookieVal && !cookieVal->empty() && *cookieVal != "0")
-        tmplt = Misc::GetTemplateInfoFromDB(*cookieVal);
-    else
-    {
-        tmplt.name = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_NAME);
-        tmplt.stylePath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH);
-        tmplt.tmpltPath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH);
-        tmplt.currentTemplate = Misc::GetTemplate(tmplt.tmpltPath, tmplt.name);
-    }
+    TemplateInfo tmplt = sTemplateRegistry.GetTemplate(cookieVal ? *cookieVal : std::string());
 
     useStyleSheet(tmplt.GetFullStylePath());
 
     root()->setStyleClass("main");
 
     // page creation
-    templ = new Wt::WTemplate(root());
+    templ = new PanelTemplate(root());
 
     content =  new Wt::WStackedWidget();
     langs = new LangsWidget();
@@ -87,7 +92,7 @@ PlayersPanel::PlayersPanel(const Wt::WEnvironment& env)
     templ->setCondition("if-loggedin", false);
     templ->setCondition("if-notlogged", true);
 
-    templ->setTemplateText(tmplt.currentTemplate);
+    templ->SetTemplate(tmplt);
 }
 
 PlayersPanel::~PlayersPanel()
@@ -102,8 +107,6 @@ WApplication * CreateApplication(const Wt::WEnvironment& env)
     // You could read information from the environment to decide
     // whether the user has permission to start a new application
 
-    sConfig.ReadConfig();
-
     PlayersPanel * tmpPanel = new PlayersPanel(env);
 
     return tmpPanel;
@@ -112,5 +115,73 @@ WApplication * CreateApplication(const Wt::WEnvironment& env)
 int main(int argc, char **argv)
 {
     srand(time(NULL));
-    return WRun(argc, argv, &CreateApplication);
+
+    // sessions use published snapshot, watcher swaps it when config file changes
+    if (!sConfig.ReadConfig())
+        return 1;
+
+    sConfig.StartWatcher();
+
+    // shared by all sessions, must be loaded before server start
+    if (!sMessageStore.Load("langs/panel"))
+        return 1;
+
+    // loads templates before first session
+    TemplateRegistry::Instance();
+
+    // spells are loaded once and shared read only by all sessions
+    SpellDictionary::Instance();
+
+    int result = 0;
+
+    // same as WRun but with public status resources which don't need session
+    try
+    {
+        // server doesn't own added resources, declared before it so they are destroyed after server
+        StatusResource jsonStatus(STATUS_RESOURCE_JSON);
+        StatusResource textStatus(STATUS_RESOURCE_TEXT);
+
+        Wt::WServer server(argv[0]);
+
+        server.setServerConfiguration(argc, argv, WTHTTP_CONFIGURATION);
+
+        server.addResource(&jsonStatus, "/status.json");
+        server.addResource(&textStatus, "/status.txt");
+        server.addEntryPoint(Wt::Application, &CreateApplication);
+
+        if (server.start())
+        {
+            int sig = Wt::WServer::waitForShutdown(argv[0]);
+
+            std::cerr << "Shutdown (signal = " << sig << ")" << std::endl;
+
+            // background threads use server (io service, posts to sessions), so they are stopped before it
+            sConfig.StopWatcher();
+            DatabaseExecutor::Shutdown();
+            ActivityLog::Shutdown();
+            RealmStatusPoller::Shutdown();
+            TemplateRegistry::Shutdown();
+
+            server.stop();
+        }
+    }
+    catch (Wt::WServer::Exception & e)
+    {
+        std::cerr << e.what() << std::endl;
+        result = 1;
+    }
+    catch (std::exception & e)
+    {
+        std::cerr << "exception: " << e.what() << std::endl;
+        result = 1;
+    }
+
+    // server wasn't started (or threw) - threads started before it are stopped here, already stopped ones are skipped
+    sConfig.StopWatcher();
+    DatabaseExecutor::Shutdown();
+    ActivityLog::Shutdown();
+    RealmStatusPoller::Shutdown();
+    TemplateRegistry::Shutdown();
+
+    return result;
 }
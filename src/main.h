@@ -26,6 +26,7 @@
 class LangsWidget;
 class LoginWidget;
 class HGMenu;
+class PanelTemplate;
 class TemplateWidget;
 
 class PlayersPanel : public Wt::WApplication
@@ -38,7 +39,7 @@ private:
     Wt::WStackedWidget * content;       // container to show menu items after click (main content container)
     SessionInfo * session;              // store info about user session
 
-    Wt::WTemplate * templ;
+    PanelTemplate * templ;
     LangsWidget * langs;
     LoginWidget * login;
     HGMenu * menu;
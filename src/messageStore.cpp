@@ -0,0 +1,328 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "messageStore.h"
+
+#include <sstream>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <Wt/WApplication>
+
+#include "LangsWidget.h"
+#include "misc.h"
+
+MessageStore & MessageStore::Instance()
+{
+    // same as in Config::Instance()
+    if (_store == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_store == nullptr)
+            _store = new MessageStore();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<MessageStore*>(_store);
+}
+
+static void AppendEscaped(const std::string & text, std::string & result)
+{
+    for (std::string::const_iterator itr = text.begin(); itr != text.end(); ++itr)
+    {
+        switch (*itr)
+        {
+            case '&':
+                result += "&amp;";
+                break;
+            case '<':
+                result += "&lt;";
+                break;
+            case '>':
+                result += "&gt;";
+                break;
+            case '"':
+                result += "&quot;";
+                break;
+            default:
+                result += *itr;
+                break;
+        }
+    }
+}
+
+// writes node children back as xhtml, texts are stored as separate <xmltext> nodes so order is kept
+static void AppendContent(const boost::property_tree::ptree & node, std::string & result)
+{
+    for (boost::property_tree::ptree::const_iterator itr = node.begin(); itr != node.end(); ++itr)
+    {
+        if (itr->first == "<xmlattr>")
+            continue;
+
+        if (itr->first == "<xmltext>")
+        {
+            AppendEscaped(itr->second.data(), result);
+            continue;
+        }
+
+        result += '<';
+        result += itr->first;
+
+        if (boost::optional<const boost::property_tree::ptree &> attributes = itr->second.get_child_optional("<xmlattr>"))
+        {
+            for (boost::property_tree::ptree::const_iterator attr = attributes->begin(); attr != attributes->end(); ++attr)
+            {
+                result += ' ' + attr->first + "=\"";
+                AppendEscaped(attr->second.data(), result);
+                result += '"';
+            }
+        }
+
+        std::string content;
+        AppendContent(itr->second, content);
+
+        if (content.empty())
+            result += " />";
+        else
+            result += '>' + content + "</" + itr->first + '>';
+    }
+}
+
+bool MessageStore::LoadFile(const std::string & fileName, MessagesMap & messages)
+{
+    // read at once and checked for UTF-8 same as templates
+    std::string text = Misc::GetTemplate(fileName);
+
+    if (text.empty())
+        return false;
+
+    boost::property_tree::ptree pt;
+    std::istringstream stream(text);
+
+    try
+    {
+        // comments are skipped, CDATA is read as text
+        boost::property_tree::xml_parser::read_xml(stream, pt, boost::property_tree::xml_parser::no_comments | boost::property_tree::xml_parser::no_concat_text);
+    }
+    catch (boost::property_tree::xml_parser::xml_parser_error & e)
+    {
+        Misc::Console(DEBUG_CODE, "%s: can't parse %s: %s\n", __FUNCTION__, fileName.c_str(), e.what());
+        return false;
+    }
+
+    boost::optional<boost::property_tree::ptree &> root = pt.get_child_optional("messages");
+
+    if (!root)
+    {
+        Misc::Console(DEBUG_CODE, "%s: %s doesn't contain messages element\n", __FUNCTION__, fileName.c_str());
+        return false;
+    }
+
+    for (boost::property_tree::ptree::const_iterator itr = root->begin(); itr != root->end(); ++itr)
+    {
+        if (itr->first != "message")
+            continue;
+
+        boost::optional<std::string> id = itr->second.get_optional<std::string>("<xmlattr>.id");
+
+        if (!id)
+        {
+            Misc::Console(DEBUG_CODE, "%s: message without id in %s\n", __FUNCTION__, fileName.c_str());
+            continue;
+        }
+
+        // messages contain xhtml, so it's passed to widgets as xml
+        std::string & message = messages[*id];
+        message.clear();
+        AppendContent(itr->second, message);
+    }
+
+    messages.rehash(messages.size());
+
+    return true;
+}
+
+bool MessageStore::Load(const std::string & path)
+{
+    if (!LoadFile(path + ".xml", defaultMessages))
+    {
+        Misc::Console(DEBUG_CODE, "%s: can't load messages from %s.xml\n", __FUNCTION__, path.c_str());
+        return false;
+    }
+
+    for (int i = 0; i < LANG_COUNT; ++i)
+    {
+        std::string locale = LangsWidget::GetLocaleName(Lang(i));
+        MessagesMap messages;
+
+        // not all langs are translated, missing messages are taken from default file
+        if (localeMessages.find(locale) == localeMessages.end() && LoadFile(path + "_" + locale + ".xml", messages))
+            localeMessages[locale].swap(messages);
+    }
+
+    Misc::Console(DEBUG_CODE, "%s: loaded %u default messages and %u translations\n", __FUNCTION__, uint32(defaultMessages.size()), uint32(localeMessages.size()));
+
+    return true;
+}
+
+const MessagesMap * MessageStore::FindLocaleMessages(const std::string & locale, std::string * lang) const
+{
+    std::unordered_map<std::string, MessagesMap>::const_iterator localeItr = localeMessages.find(locale);
+
+    // locale can contain region (pl-PL), translation files use only lang name
+    if (localeItr == localeMessages.end() && locale.find('-') != std::string::npos)
+        localeItr = localeMessages.find(locale.substr(0, locale.find('-')));
+
+    if (localeItr == localeMessages.end())
+        return NULL;
+
+    if (lang)
+        *lang = localeItr->first;
+
+    return &localeItr->second;
+}
+
+bool MessageStore::ResolveKey(const std::string & locale, const std::string & key, std::string & result) const
+{
+    if (const MessagesMap * messages = FindLocaleMessages(locale))
+    {
+        MessagesMap::const_iterator itr = messages->find(key);
+
+        if (itr != messages->end())
+        {
+            result = itr->second;
+            return true;
+        }
+    }
+
+    MessagesMap::const_iterator itr = defaultMessages.find(key);
+
+    if (itr == defaultMessages.end())
+        return false;
+
+    result = itr->second;
+    return true;
+}
+
+const EnumNames & MessageStore::GetEnumNames() const
+{
+    Wt::WApplication * app = Wt::WApplication::instance();
+
+    return GetEnumNames(app ? app->locale().name() : std::string());
+}
+
+const EnumNames & MessageStore::GetEnumNames(const std::string & locale) const
+{
+    // tables are kept per translation file, so locales with region or without translation share them
+    std::string lang;
+    FindLocaleMessages(locale, &lang);
+
+    std::lock_guard<std::mutex> lock(enumNamesMutex);
+
+    std::unordered_map<std::string, std::unique_ptr<EnumNames> >::const_iterator itr = enumNames.find(lang);
+
+    if (itr != enumNames.end())
+        return *itr->second;
+
+    EnumNames * names = new EnumNames();
+    BuildEnumNames(lang, *names);
+
+    // tables are allocated separately, so returned references stay valid when map grows
+    enumNames[lang].reset(names);
+
+    return *names;
+}
+
+Wt::WString MessageStore::ResolveName(const std::string & lang, const char * key) const
+{
+    std::string text;
+
+    // same as WString::tr() for missing message
+    if (!ResolveKey(lang, key, text))
+        return Wt::WString::fromUTF8("??" + std::string(key) + "??");
+
+    return Wt::WString::fromUTF8(text);
+}
+
+void MessageStore::BuildEnumNames(const std::string & lang, EnumNames & names) const
+{
+    // resolved once per lang, so table building loops only index arrays
+    names.unknown = ResolveName(lang, TXT_GEN_UNKNOWN);
+
+    for (int i = 0; i < MAX_RACES; ++i)
+        names.races[i] = names.unknown;
+
+    names.races[RACE_HUMAN] = ResolveName(lang, TXT_RACE_HUMAN);
+    names.races[RACE_ORC] = ResolveName(lang, TXT_RACE_ORC);
+    names.races[RACE_DWARF] = ResolveName(lang, TXT_RACE_DWARF);
+    names.races[RACE_NIGHT_ELF] = ResolveName(lang, TXT_RACE_NIGHT_ELF);
+    names.races[RACE_UNDEAD] = ResolveName(lang, TXT_RACE_UNDEAD);
+    names.races[RACE_TAUREN] = ResolveName(lang, TXT_RACE_TAUREN);
+    names.races[RACE_GNOME] = ResolveName(lang, TXT_RACE_GNOME);
+    names.races[RACE_TROLL] = ResolveName(lang, TXT_RACE_TROLL);
+    names.races[RACE_BLOOD_ELF] = ResolveName(lang, TXT_RACE_BLOOD_ELF);
+    names.races[RACE_DRAENEI] = ResolveName(lang, TXT_RACE_DRAENEI);
+
+    for (int i = 0; i < MAX_CLASSES; ++i)
+        names.classes[i] = names.unknown;
+
+    names.classes[CLASS_WARRIOR] = ResolveName(lang, TXT_CLASS_WARRIOR);
+    names.classes[CLASS_PALADIN] = ResolveName(lang, TXT_CLASS_PALADIN);
+    names.classes[CLASS_HUNTER] = ResolveName(lang, TXT_CLASS_HUNTER);
+    names.classes[CLASS_ROGUE] = ResolveName(lang, TXT_CLASS_ROGUE);
+    names.classes[CLASS_PRIEST] = ResolveName(lang, TXT_CLASS_PRIEST);
+    names.classes[CLASS_SHAMAN] = ResolveName(lang, TXT_CLASS_SHAMAN);
+    names.classes[CLASS_MAGE] = ResolveName(lang, TXT_CLASS_MAGE);
+    names.classes[CLASS_WARLOCK] = ResolveName(lang, TXT_CLASS_WARLOCK);
+    names.classes[CLASS_DRUID] = ResolveName(lang, TXT_CLASS_DRUID);
+
+    names.questStatus[0] = ResolveName(lang, TXT_QUEST_STATUS_NONE);
+    names.questStatus[1] = ResolveName(lang, TXT_QUEST_STATUS_COMPLETE);
+    names.questStatus[2] = ResolveName(lang, TXT_QUEST_STATUS_UNAVAILABLE);
+    names.questStatus[3] = ResolveName(lang, TXT_QUEST_STATUS_INCOMPLETE);
+    names.questStatus[4] = ResolveName(lang, TXT_QUEST_STATUS_AVAILABLE);
+    names.questRewarded = ResolveName(lang, TXT_QUEST_STATUS_REWARDED);
+
+    names.expansions[EXPANSION_PRETBC] = ResolveName(lang, TXT_EXPANSION_CLASSIC);
+    names.expansions[EXPANSION_TBC] = ResolveName(lang, TXT_EXPANSION_TBC);
+    names.expansions[EXPANSION_WOTLK] = ResolveName(lang, TXT_EXPANSION_WOTLK);
+    names.expansions[EXPANSION_CATA] = ResolveName(lang, TXT_EXPANSION_CATACLYSM);
+
+    names.clientLocales[0] = ResolveName(lang, "locale.enus");
+    names.clientLocales[1] = ResolveName(lang, "locale.kokr");
+    names.clientLocales[2] = ResolveName(lang, "locale.frfr");
+    names.clientLocales[3] = ResolveName(lang, "locale.dede");
+    names.clientLocales[4] = ResolveName(lang, "locale.zhcn");
+    names.clientLocales[5] = ResolveName(lang, "locale.zhtw");
+    names.clientLocales[6] = ResolveName(lang, "locale.eses");
+    names.clientLocales[7] = ResolveName(lang, "locale.esmx");
+    names.clientLocales[8] = ResolveName(lang, "locale.ruru");
+    names.clientLocaleUnknown = ResolveName(lang, "unknown");
+}
+
+volatile MessageStore * MessageStore::_store = nullptr;
+std::mutex MessageStore::_createMutex;
+
+bool SessionMessages::resolveKey(const std::string & key, std::string & result)
+{
+    Wt::WApplication * app = Wt::WApplication::instance();
+
+    return sMessageStore.ResolveKey(app ? app->locale().name() : std::string(), key, result);
+}
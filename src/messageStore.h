@@ -0,0 +1,122 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MESSAGE_STORE_H_INCLUDED
+#define MESSAGE_STORE_H_INCLUDED
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <Wt/WLocalizedStrings>
+#include <Wt/WString>
+
+#include "defines.h"
+
+typedef std::unordered_map<std::string, std::string> MessagesMap;
+
+#define QUEST_STATUS_COUNT      5   /// quest status values from character_queststatus (without rewarded)
+#define CLIENT_LOCALE_COUNT     9   /// client locale ids from account table
+
+/********************************************//**
+ * \brief Names for enum values resolved for one lang.
+ *
+ * Tables are indexed directly by enum value, values
+ * without own name contain TXT_GEN_UNKNOWN text.
+ * Names are plain texts, so widgets showing them
+ * must be filled again when session locale changes.
+ *
+ ***********************************************/
+
+struct EnumNames
+{
+    Wt::WString races[MAX_RACES];
+    Wt::WString classes[MAX_CLASSES];
+    Wt::WString questStatus[QUEST_STATUS_COUNT];
+    Wt::WString questRewarded;
+    Wt::WString expansions[MAX_EXPANSIONS];
+    Wt::WString clientLocales[CLIENT_LOCALE_COUNT];
+    Wt::WString clientLocaleUnknown;
+    Wt::WString unknown;
+};
+
+/********************************************//**
+ * \brief Process wide localized messages.
+ *
+ * All langs/panel*.xml files are loaded once on start
+ * (before server start) and aren't changed later,
+ * so sessions can read them without any locking.
+ * Previously every session had own message resource
+ * bundle with copy of all messages.
+ *
+ * Names for races, classes etc. are resolved
+ * when lang is used first time, so table building
+ * loops don't need switch and message lookup
+ * for every row.
+ *
+ ***********************************************/
+
+class MessageStore
+{
+public:
+    static MessageStore & Instance();
+
+    bool Load(const std::string & path);                /// loads path.xml (default messages) and path_<locale>.xml files, returns false when default file can't be loaded
+    bool ResolveKey(const std::string & locale, const std::string & key, std::string & result) const; /// locale messages are used first, then default ones
+
+    const EnumNames & GetEnumNames() const;             /// returns enum names for current session locale
+    const EnumNames & GetEnumNames(const std::string & locale) const;  /// returns enum names for given locale, tables are built on first use
+
+private:
+    MessageStore() {}
+    MessageStore(const MessageStore &) {}
+    ~MessageStore() {}
+
+    static bool LoadFile(const std::string & fileName, MessagesMap & messages);
+
+    const MessagesMap * FindLocaleMessages(const std::string & locale, std::string * lang = NULL) const; /// returns translation for locale (or NULL), lang is set to its name
+    void BuildEnumNames(const std::string & lang, EnumNames & names) const;
+    Wt::WString ResolveName(const std::string & lang, const char * key) const;
+
+    MessagesMap defaultMessages;
+    std::unordered_map<std::string, MessagesMap> localeMessages;
+
+    mutable std::unordered_map<std::string, std::unique_ptr<EnumNames> > enumNames;   /// lang ("" for default messages) to its names
+    mutable std::mutex enumNamesMutex;
+
+    static volatile MessageStore * _store;
+    static std::mutex _createMutex;
+};
+
+#define sMessageStore MessageStore::Instance()
+
+/********************************************//**
+ * \brief Session localized strings.
+ *
+ * Doesn't store any messages, only resolves keys
+ * in MessageStore for current session locale.
+ *
+ ***********************************************/
+
+class SessionMessages : public Wt::WLocalizedStrings
+{
+public:
+    bool resolveKey(const std::string & key, std::string & result);
+};
+
+#endif // MESSAGE_STORE_H_INCLUDED
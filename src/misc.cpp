@@ -22,6 +22,7 @@
 
 #include <jwsmtp/jwsmtp.h>
 #include <Wt/WApplication>
+#include <Wt/WLogger>
 
 #include "config.h"
 #include "database.h"
@@ -80,7 +81,11 @@ void Misc::Log(LogFlags flag, char const* text, ...)
         vsprintf(buffer, text, args);
         va_end(args);
 
-        wApp->log("notice") << buffer;
+        // background threads (db executor, activity log) don't have application
+        if (wApp)
+            wApp->log("notice") << buffer;
+        else
+            Wt::log("notice") << buffer;
     }
 }
 
@@ -97,88 +102,102 @@ std::string Misc::GetFormattedString(const char * format, ...)
     return std::string(buffer);
 }
 
-std::string Misc::GetTemplate(const std::string & fullPath)
+/********************************************//**
+ * \brief Checks if text is correct UTF-8.
+ *
+ * Overlong forms, surrogates and code points
+ * above U+10FFFF are treated as invalid.
+ *
+ ***********************************************/
+
+static bool IsValidUTF8(const std::string & text)
 {
-    std::string templateStr;
-    std::fstream tmpltFile;
+    const uint8 * itr = (const uint8*)text.data();
+    const uint8 * end = itr + text.size();
 
-    tmpltFile.open(fullPath.c_str(), std::fstream::in);
-    if (tmpltFile.is_open() && tmpltFile.good())
+    while (itr < end)
     {
-        char tmpStr[1000];
-        while (!tmpltFile.eof())
+        uint8 c = *itr++;
+
+        if (c < 0x80)
+            continue;
+
+        uint32 length, codePoint;
+
+        if (c >= 0xC2 && c <= 0xDF)
+        {
+            length = 1;
+            codePoint = c & 0x1F;
+        }
+        else if (c >= 0xE0 && c <= 0xEF)
+        {
+            length = 2;
+            codePoint = c & 0x0F;
+        }
+        else if (c >= 0xF0 && c <= 0xF4)
+        {
+            length = 3;
+            codePoint = c & 0x07;
+        }
+        else
+            return false;
+
+        if (uint32(end - itr) < length)
+            return false;
+
+        for (uint32 i = 0; i < length; ++i, ++itr)
         {
-            tmpltFile.getline(tmpStr, 1000, '\n');
-            templateStr += tmpStr;
+            if ((*itr & 0xC0) != 0x80)
+                return false;
+
+            codePoint = (codePoint << 6) | (*itr & 0x3F);
         }
+
+        if ((length == 2 && codePoint < 0x800) || (length == 3 && codePoint < 0x10000) ||
+            (codePoint >= 0xD800 && codePoint <= 0xDFFF) || codePoint > 0x10FFFF)
+            return false;
     }
-    tmpltFile.close();
 
-    return templateStr;
+    return true;
 }
 
-std::string Misc::GetTemplate(const std::string & tmpltPath, const std::string & name)
+std::string Misc::GetTemplate(const std::string & fullPath)
 {
-    return GetTemplate(tmpltPath + "/" + name + ".tmplt");
-}
+    std::ifstream tmpltFile(fullPath.c_str(), std::ifstream::in | std::ifstream::binary);
 
-TemplateInfo Misc::GetTemplateInfoFromDB(const std::string & name)
-{
-    TemplateInfo templateInfo;
-    Database db;
+    if (!tmpltFile.is_open())
+        return std::string();
 
-    if (db.Connect(DB_PANEL_DATA))
-    {
-        std::string tmpName = db.EscapeString(name);
-        if (db.ExecutePQuery("SELECT name, stylePath, tmpltPath FROM Templates WHERE name = '%s'", tmpName.c_str()) > DB_RESULT_EMPTY)
-        {
-            templateInfo.name = db.GetRow()->fields[0].GetString();
-            templateInfo.stylePath = db.GetRow()->fields[1].GetString();
-            templateInfo.tmpltPath = db.GetRow()->fields[2].GetString();
+    tmpltFile.seekg(0, std::ifstream::end);
+    std::streamoff size = tmpltFile.tellg();
+    tmpltFile.seekg(0, std::ifstream::beg);
 
-            templateInfo.currentTemplate = GetTemplate(templateInfo.GetFullTemplatePath());
-        }
-    }
+    if (size <= 0)
+        return std::string();
 
-    if (templateInfo.currentTemplate.empty() || templateInfo.stylePath.empty())
+    // whole file is read at once, template is kept as it is in file (with new lines)
+    std::string templateStr(size_t(size), '\0');
+
+    if (!tmpltFile.read(&templateStr[0], size))
     {
-        templateInfo.name = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_NAME);
-        templateInfo.stylePath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH);
-        templateInfo.tmpltPath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH);
+        Misc::Console(DEBUG_CODE, "%s: can't read %s\n", __FUNCTION__, fullPath.c_str());
+        return std::string();
     }
 
-    return templateInfo;
-}
-
-TemplateInfo Misc::GetTemplateInfoFromDB(const Wt::WString & name)
-{
-    return GetTemplateInfoFromDB(name.toUTF8());
-}
+    // skip UTF-8 BOM
+    if (templateStr.compare(0, 3, "\xEF\xBB\xBF") == 0)
+        templateStr.erase(0, 3);
 
-std::vector<TemplateInfo> Misc::GetTemplatesFromDB()
-{
-    std::vector<TemplateInfo> templates;
-    Database db;
-    if (db.Connect(DB_PANEL_DATA))
+    if (!IsValidUTF8(templateStr))
     {
-        if (db.ExecutePQuery("SELECT name, stylePath, tmpltPath FROM Templates") > DB_RESULT_EMPTY)
-        {
-            std::list<DatabaseRow*> tmpRows = db.GetRows();
-            const DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = tmpRows.begin(); itr != tmpRows.end(); ++itr)
-            {
-                tmpRow = *itr;
-
-                TemplateInfo tmplt;
-                tmplt.name = tmpRow->fields[0].GetString();
-                tmplt.stylePath = tmpRow->fields[1].GetString();
-                tmplt.tmpltPath = tmpRow->fields[2].GetString();
-                tmplt.currentTemplate = GetTemplate(tmplt.tmpltPath, tmplt.name);
-
-                templates.push_back(tmplt);
-            }
-        }
+        Misc::Console(DEBUG_CODE, "%s: %s isn't valid UTF-8 file\n", __FUNCTION__, fullPath.c_str());
+        return std::string();
     }
 
-    return templates;
+    return templateStr;
+}
+
+std::string Misc::GetTemplate(const std::string & tmpltPath, const std::string & name)
+{
+    return GetTemplate(tmpltPath + "/" + name + ".tmplt");
 }
@@ -107,6 +107,9 @@ namespace Misc
      * \param fullPath  full path to .tmplt file contains template
      * \return string containing template from .tmplt file
      *
+     * Whole file is read at once and checked if it's valid UTF-8.
+     * Returns empty string when file can't be read or isn't valid UTF-8.
+     *
      ***********************************************/
 
     std::string GetTemplate(const std::string & fullPath);
@@ -123,26 +126,6 @@ namespace Misc
      ***********************************************/
 
     std::string GetTemplate(const std::string & tmpltPath, const std::string & name);
-
-    /********************************************//**
-     * \brief Gets full template info from DB and tmplt file.
-     *
-     * \param name  template name
-     * \return template informations from DB and .tmplt file
-     *
-     ***********************************************/
-
-    TemplateInfo GetTemplateInfoFromDB(const std::string & name);
-    TemplateInfo GetTemplateInfoFromDB(const Wt::WString & name);
-
-    /********************************************//**
-     * \brief Get full tamplate info for all templates in DB.
-     *
-     * \return vector with template info for templates recorded in DB
-     *
-     ***********************************************/
-
-    std::vector<TemplateInfo> GetTemplatesFromDB();
 }
 
 #endif // MISC_H_INCLUDED
@@ -17,8 +17,8 @@
 
 #include "miscAccount.h"
 
+#include "activityLog.h"
 #include "config.h"
-#include "database.h"
 #include "misc.h"
 
 std::string Misc::Account::GeneratePassword()
@@ -33,15 +33,14 @@ std::string Misc::Account::GeneratePassword()
     return tmpStr;
 }
 
+// activities are written in background by activity log
+
 void Misc::Account::AddActivity(uint32 accountId, const char * ip, const char * activity, const char * activityArgs)
 {
     if (!accountId || !activity || !activityArgs)
         return;
 
-    Database db;
-
-    db.Connect(DB_PANEL_DATA);
-    db.ExecutePQuery("INSERT INTO Activity VALUES ('%u', NOW(), '%s', '%s', '%s')", accountId, ip, activity, activityArgs);
+    sActivityLog.Add(accountId, ip ? ip : "", activity, activityArgs);
 }
 
 void Misc::Account::AddActivity(uint32 accountId, const std::string & ip, const char * activity, const std::string & activityArgs)
@@ -49,67 +48,23 @@ void Misc::Account::AddActivity(uint32 accountId, const std::string & ip, const
     if (!accountId || !activity)
         return;
 
-    Database db;
-
-    db.Connect(DB_PANEL_DATA);
-    db.ExecutePQuery("INSERT INTO Activity VALUES ('%u', NOW(), '%s', '%s', '%s')", accountId, ip.c_str(), activity, activityArgs.c_str());
-
+    sActivityLog.Add(accountId, ip, activity, activityArgs);
 }
 
-void Misc::Account::AddActivity(const char * username, const char * ip, const char * activity, const char * activityArgs, bool escape)
+// username and args are passed as they are, activity log escapes them when query is built
+
+void Misc::Account::AddActivity(const char * username, const char * ip, const char * activity, const char * activityArgs)
 {
     if (!username || !activity || !activityArgs)
         return;
 
-    Database db;
-
-    if (!db.Connect(DB_ACCOUNTS_DATA))
-        return;
-
-    uint32 accountId;
-
-    std::string tmpUsr;
-
-    if (escape)
-        tmpUsr = db.EscapeString(username);
-    else
-        tmpUsr = username;
-
-    if (db.ExecutePQuery("SELECT account_id FROM account WHERE username = '%s'", tmpUsr.c_str()) > DB_RESULT_EMPTY)
-        accountId = db.GetRow()->fields[0].GetUInt32();
-    else
-        return;
-
-    db.Disconnect();
-
-    AddActivity(accountId, ip, activity, activityArgs);
+    sActivityLog.Add(username, ip ? ip : "", activity, activityArgs);
 }
 
-void Misc::Account::AddActivity(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs, bool escape)
+void Misc::Account::AddActivity(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs)
 {
     if (username.empty() || !activity)
         return;
 
-    Database db;
-
-    if (!db.Connect(DB_ACCOUNTS_DATA))
-        return;
-
-    uint32 accountId;
-
-    std::string tmpUsr;
-
-    if (escape)
-        tmpUsr = db.EscapeString(username);
-    else
-        tmpUsr = username;
-
-    if (db.ExecutePQuery("SELECT account_id FROM account WHERE username = '%s'", tmpUsr.c_str()) > DB_RESULT_EMPTY)
-        accountId = db.GetRow()->fields[0].GetUInt32();
-    else
-        return;
-
-    db.Disconnect();
-
-    AddActivity(accountId, ip, activity, activityArgs);
+    sActivityLog.Add(username, ip, activity, activityArgs);
 }
@@ -26,8 +26,8 @@ namespace Misc
     {
         void AddActivity(uint32 accountId, const char * ip, const char * activity, const char * activityArgs);
         void AddActivity(uint32 accountId, const std::string & ip, const char * activity, const std::string & activityArgs);
-        void AddActivity(const char * username, const char * ip, const char * activity, const char * activityArgs, bool escape = false);
-        void AddActivity(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs, bool escape = false);
+        void AddActivity(const char * username, const char * ip, const char * activity, const char * activityArgs);
+        void AddActivity(const std::string & username, const std::string & ip, const char * activity, const std::string & activityArgs);
 
         std::string GeneratePassword();
     }
@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include "defines.h"
+#include "messageStore.h"
 
 ConflictSide Misc::Character::GetSide(const uint8 & race)
 {
@@ -121,78 +122,24 @@ std::string Misc::Character::GetGlobalRaceName(int index)
 
 Wt::WString Misc::Character::GetRaceName(int index)
 {
-    switch (index)
-    {
-        case RACE_HUMAN:
-            return Wt::WString::tr(TXT_RACE_HUMAN);
-        case RACE_ORC:
-            return Wt::WString::tr(TXT_RACE_ORC);
-        case RACE_DWARF:
-            return Wt::WString::tr(TXT_RACE_DWARF);
-        case RACE_NIGHT_ELF:
-            return Wt::WString::tr(TXT_RACE_NIGHT_ELF);
-        case RACE_UNDEAD:
-            return Wt::WString::tr(TXT_RACE_UNDEAD);
-        case RACE_TAUREN:
-            return Wt::WString::tr(TXT_RACE_TAUREN);
-        case RACE_GNOME:
-            return Wt::WString::tr(TXT_RACE_GNOME);
-        case RACE_TROLL:
-            return Wt::WString::tr(TXT_RACE_TROLL);
-        case RACE_BLOOD_ELF:
-            return Wt::WString::tr(TXT_RACE_BLOOD_ELF);
-        case RACE_DRAENEI:
-            return Wt::WString::tr(TXT_RACE_DRAENEI);
-        default:
-            return Wt::WString::tr(TXT_GEN_UNKNOWN);
-    }
+    const EnumNames & names = sMessageStore.GetEnumNames();
+
+    return index >= 0 && index < MAX_RACES ? names.races[index] : names.unknown;
 }
 
 Wt::WString Misc::Character::GetClassName(int index)
 {
-    switch (index)
-    {
-        case CLASS_WARRIOR:
-            return Wt::WString::tr(TXT_CLASS_WARRIOR);
-        case CLASS_PALADIN:
-            return Wt::WString::tr(TXT_CLASS_PALADIN);
-        case CLASS_HUNTER:
-            return Wt::WString::tr(TXT_CLASS_HUNTER);
-        case CLASS_ROGUE:
-            return Wt::WString::tr(TXT_CLASS_ROGUE);
-        case CLASS_PRIEST:
-            return Wt::WString::tr(TXT_CLASS_PRIEST);
-        case CLASS_SHAMAN:
-            return Wt::WString::tr(TXT_CLASS_SHAMAN);
-        case CLASS_MAGE:
-            return Wt::WString::tr(TXT_CLASS_MAGE);
-        case CLASS_WARLOCK:
-            return Wt::WString::tr(TXT_CLASS_WARLOCK);
-        case CLASS_DRUID:
-            return Wt::WString::tr(TXT_CLASS_DRUID);
-        default:
-            return Wt::WString::tr(TXT_GEN_UNKNOWN);
-    }
+    const EnumNames & names = sMessageStore.GetEnumNames();
+
+    return index >= 0 && index < MAX_CLASSES ? names.classes[index] : names.unknown;
 }
 
 Wt::WString Misc::Character::GetQuestStatus(int index, bool rewarded)
 {
+    const EnumNames & names = sMessageStore.GetEnumNames();
+
     if (rewarded)
-        return Wt::WString::tr(TXT_QUEST_STATUS_REWARDED);
+        return names.questRewarded;
 
-    switch (index)
-    {
-        case 0:
-            return Wt::WString::tr(TXT_QUEST_STATUS_NONE);
-        case 1:
-            return Wt::WString::tr(TXT_QUEST_STATUS_COMPLETE);
-        case 2:
-            return Wt::WString::tr(TXT_QUEST_STATUS_UNAVAILABLE);
-        case 3:
-            return Wt::WString::tr(TXT_QUEST_STATUS_INCOMPLETE);
-        case 4:
-            return Wt::WString::tr(TXT_QUEST_STATUS_AVAILABLE);
-        default:
-            return Wt::WString::tr(TXT_GEN_UNKNOWN);
-    }
+    return index >= 0 && index < QUEST_STATUS_COUNT ? names.questStatus[index] : names.unknown;
 }
@@ -18,46 +18,19 @@
 #include "miscClient.h"
 
 #include "defines.h"
+#include "messageStore.h"
 
 Wt::WString Misc::Client::GetExpansionName(int index)
 {
-    switch (index)
-    {
-        case EXPANSION_TBC:
-            return Wt::WString::tr(TXT_EXPANSION_TBC);
-        case EXPANSION_WOTLK:
-            return Wt::WString::tr(TXT_EXPANSION_WOTLK);
-        case EXPANSION_CATA:
-            return Wt::WString::tr(TXT_EXPANSION_CATACLYSM);
-        case EXPANSION_PRETBC:
-        default:
-            return Wt::WString::tr(TXT_EXPANSION_CLASSIC);
-    }
+    const EnumNames & names = sMessageStore.GetEnumNames();
+
+    // unknown expansions were shown as classic
+    return index >= 0 && index < MAX_EXPANSIONS ? names.expansions[index] : names.expansions[EXPANSION_PRETBC];
 }
 
 Wt::WString Misc::Client::GetLocale(int index)
 {
-    switch (index)
-    {
-        case 0:
-            return Wt::WString::tr("locale.enus");
-        case 1:
-            return Wt::WString::tr("locale.kokr");
-        case 2:
-            return Wt::WString::tr("locale.frfr");
-        case 3:
-            return Wt::WString::tr("locale.dede");
-        case 4:
-            return Wt::WString::tr("locale.zhcn");
-        case 5:
-            return Wt::WString::tr("locale.zhtw");
-        case 6:
-            return Wt::WString::tr("locale.eses");
-        case 7:
-            return Wt::WString::tr("locale.esmx");
-        case 8:
-            return Wt::WString::tr("locale.ruru");
-        default:
-            return Wt::WString::tr("unknown");
-    }
+    const EnumNames & names = sMessageStore.GetEnumNames();
+
+    return index >= 0 && index < CLIENT_LOCALE_COUNT ? names.clientLocales[index] : names.clientLocaleUnknown;
 }
@@ -0,0 +1,350 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pagedQueryModel.h"
+
+#include <cstring>
+#include <unordered_map>
+
+#include "config.h"
+#include "misc.h"
+
+PagedQueryModel::PagedQueryModel(const std::string & columns, const std::string & from, const std::string & where, const std::string & key, Wt::WObject * parent)
+: Wt::WAbstractTableModel(parent), columns(columns), from(from), where(where), key(key),
+  realm(0), guid(0), rows(0), sortColumn(-1), sortOrder(Wt::AscendingOrder), fetchedRows(0), fetchedAll(true)
+{
+}
+
+int PagedQueryModel::Load(int realmId, uint64 characterGuid)
+{
+    bool refresh = rows && realmId == realm && characterGuid == guid;
+
+    if (!refresh)
+        Clear();
+
+    Database db;
+    if (!db.Connect(DB_REALM_DATA(realmId)))
+        return DB_RESULT_ERROR;
+
+    std::string query = "SELECT COUNT(*) FROM " + from + " WHERE " + where;
+
+    if (db.ExecuteStatement(query.c_str(), DatabaseParams().AddUInt64(characterGuid)) == DB_RESULT_ERROR)
+        return DB_RESULT_ERROR;
+
+    int count = db.GetRow()->fields[0].GetInt();
+
+    db.Disconnect();
+
+    if (refresh)
+    {
+        Refresh(count);
+        return rows ? rows : DB_RESULT_EMPTY;
+    }
+
+    realm = realmId;
+    guid = characterGuid;
+    rows = count;
+    fetchedAll = rows == 0;
+
+    if (!rows)
+        return DB_RESULT_EMPTY;
+
+    // count is shown at once, so rows are inserted as one block
+    beginInsertRows(Wt::WModelIndex(), 0, rows - 1);
+    endInsertRows();
+
+    return rows;
+}
+
+static std::string GetRowKey(const DatabaseRow & row)
+{
+    const DatabaseField & key = row.fields[row.count - 1];
+    return std::string(key.GetCString(), key.GetLength());
+}
+
+static bool IsSameRow(const DatabaseRow & first, const DatabaseRow & second)
+{
+    if (first.count != second.count)
+        return false;
+
+    for (int i = 0; i < first.count; ++i)
+    {
+        const DatabaseField & a = first.fields[i];
+        const DatabaseField & b = second.fields[i];
+
+        if (a.IsNull() != b.IsNull() || a.GetLength() != b.GetLength() || memcmp(a.GetCString(), b.GetCString(), a.GetLength()))
+            return false;
+    }
+
+    return true;
+}
+
+static void GetPagesRows(std::vector<DatabaseResult> & pages, std::vector<const DatabaseRow*> & result)
+{
+    for (std::vector<DatabaseResult>::iterator itr = pages.begin(); itr != pages.end(); ++itr)
+        for (uint32 i = 0; i < itr->GetRowsCount(); ++i)
+            result.push_back(itr->GetRow(i));
+}
+
+void PagedQueryModel::Refresh(int count)
+{
+    std::vector<DatabaseResult> oldPages;
+    oldPages.swap(pages);
+
+    int oldFetched = fetchedRows;
+
+    // rows fetched before were (or could be) shown, so same amount is read again and compared by key
+    // rows behind them weren't shown yet and will be fetched when needed
+    int oldRows = rows;
+    rows = count;
+    fetchedRows = 0;
+    fetchedAll = count == 0;
+
+    while (fetchedRows < oldFetched && FetchPage())
+        ;
+
+    rows = oldRows;
+
+    std::vector<const DatabaseRow*> oldList, newList;
+    GetPagesRows(oldPages, oldList);
+    GetPagesRows(pages, newList);
+
+    std::unordered_map<std::string, const DatabaseRow*> oldKeys, newKeys;
+
+    for (std::vector<const DatabaseRow*>::const_iterator itr = oldList.begin(); itr != oldList.end(); ++itr)
+        oldKeys[GetRowKey(**itr)] = *itr;
+
+    for (std::vector<const DatabaseRow*>::const_iterator itr = newList.begin(); itr != newList.end(); ++itr)
+        newKeys[GetRowKey(**itr)] = *itr;
+
+    // rows are shown in db order, so when any kept row moved (sort value changed) whole view is refreshed
+    std::vector<std::string> keptOld, keptNew;
+
+    for (std::vector<const DatabaseRow*>::const_iterator itr = oldList.begin(); itr != oldList.end(); ++itr)
+        if (newKeys.find(GetRowKey(**itr)) != newKeys.end())
+            keptOld.push_back(GetRowKey(**itr));
+
+    for (std::vector<const DatabaseRow*>::const_iterator itr = newList.begin(); itr != newList.end(); ++itr)
+        if (oldKeys.find(GetRowKey(**itr)) != oldKeys.end())
+            keptNew.push_back(GetRowKey(**itr));
+
+    if (keptOld != keptNew)
+    {
+        beginRemoveRows(Wt::WModelIndex(), 0, rows - 1);
+        rows = 0;
+        endRemoveRows();
+
+        if (count)
+        {
+            beginInsertRows(Wt::WModelIndex(), 0, count - 1);
+            rows = count;
+            endInsertRows();
+        }
+
+        return;
+    }
+
+    // removed rows, from the end so indexes of earlier rows stay valid
+    for (int i = int(oldList.size()) - 1; i >= 0; --i)
+    {
+        if (newKeys.find(GetRowKey(*oldList[i])) != newKeys.end())
+            continue;
+
+        int last = i;
+        while (i > 0 && newKeys.find(GetRowKey(*oldList[i - 1])) == newKeys.end())
+            --i;
+
+        beginRemoveRows(Wt::WModelIndex(), i, last);
+        rows -= last - i + 1;
+        endRemoveRows();
+    }
+
+    // inserted rows, now indexes of kept rows are same as in new list
+    for (int i = 0; i < int(newList.size()); ++i)
+    {
+        if (oldKeys.find(GetRowKey(*newList[i])) != oldKeys.end())
+            continue;
+
+        int first = i;
+        while (i + 1 < int(newList.size()) && oldKeys.find(GetRowKey(*newList[i + 1])) == oldKeys.end())
+            ++i;
+
+        beginInsertRows(Wt::WModelIndex(), first, i);
+        rows += i - first + 1;
+        endInsertRows();
+    }
+
+    // changed rows
+    for (int i = 0; i < int(newList.size()); ++i)
+    {
+        std::unordered_map<std::string, const DatabaseRow*>::const_iterator itr = oldKeys.find(GetRowKey(*newList[i]));
+        if (itr == oldKeys.end() || IsSameRow(*itr->second, *newList[i]))
+            continue;
+
+        int first = i;
+        while (i + 1 < int(newList.size()) && (itr = oldKeys.find(GetRowKey(*newList[i + 1]))) != oldKeys.end() && !IsSameRow(*itr->second, *newList[i + 1]))
+            ++i;
+
+        dataChanged().emit(index(first, 0), index(i, columnCount() - 1));
+    }
+
+    // rows which weren't fetched yet are only counted
+    if (count > rows)
+    {
+        beginInsertRows(Wt::WModelIndex(), rows, count - 1);
+        rows = count;
+        endInsertRows();
+    }
+    else if (count < rows)
+    {
+        beginRemoveRows(Wt::WModelIndex(), count, rows - 1);
+        rows = count;
+        endRemoveRows();
+    }
+}
+
+void PagedQueryModel::Clear()
+{
+    if (rows)
+    {
+        beginRemoveRows(Wt::WModelIndex(), 0, rows - 1);
+        rows = 0;
+        pages.clear();
+        fetchedRows = 0;
+        endRemoveRows();
+    }
+
+    fetchedAll = true;
+}
+
+std::string PagedQueryModel::GetOrderBy() const
+{
+    return sortColumn < 0 ? key : queryColumns[sortColumn].orderBy;
+}
+
+bool PagedQueryModel::FetchPage() const
+{
+    if (fetchedAll)
+        return false;
+
+    std::string orderBy = GetOrderBy();
+    const char * direction = sortOrder == Wt::AscendingOrder ? " ASC" : " DESC";
+    const char * compare = sortOrder == Wt::AscendingOrder ? " > ?" : " < ?";
+
+    // two last columns are used to find start of next page
+    std::string query = "SELECT " + columns + ", " + orderBy + ", " + key + " FROM " + from + " WHERE " + where;
+
+    DatabaseParams params;
+    params.AddUInt64(guid);
+
+    if (!pages.empty())
+    {
+        DatabaseResult & lastPage = pages.back();
+        DatabaseRow * lastRow = lastPage.GetRow(lastPage.GetRowsCount() - 1);
+        const DatabaseField & sortValue = lastRow->fields[lastRow->count - 2];
+        const DatabaseField & keyValue = lastRow->fields[lastRow->count - 1];
+
+        if (sortColumn < 0)
+        {
+            query += " AND " + key + compare;
+            params.AddString(keyValue.GetString());
+        }
+        else
+        {
+            query += " AND (" + orderBy + compare + " OR (" + orderBy + " = ? AND " + key + compare + "))";
+            params.AddString(sortValue.GetString()).AddString(sortValue.GetString()).AddString(keyValue.GetString());
+        }
+    }
+
+    query += " ORDER BY " + orderBy + direction + ", " + key + direction + " LIMIT ?";
+    params.AddUInt32(PAGED_QUERY_PAGE_SIZE);
+
+    Database db;
+    if (!db.Connect(DB_REALM_DATA(realm)))
+    {
+        fetchedAll = true;
+        return false;
+    }
+
+    int count = db.ExecuteStatement(query.c_str(), params);
+
+    // rows could be removed meanwhile, missing rows will be empty
+    if (count <= 0)
+    {
+        fetchedAll = true;
+        return false;
+    }
+
+    pages.push_back(db.GetResult());
+    fetchedRows += count;
+
+    if (count < PAGED_QUERY_PAGE_SIZE || fetchedRows >= rows)
+        fetchedAll = true;
+
+    return true;
+}
+
+int PagedQueryModel::columnCount(const Wt::WModelIndex & parent) const
+{
+    return parent.isValid() ? 0 : queryColumns.size();
+}
+
+int PagedQueryModel::rowCount(const Wt::WModelIndex & parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+boost::any PagedQueryModel::data(const Wt::WModelIndex & index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows)
+        return boost::any();
+
+    // pages must be read in order, view asks only for visible rows
+    while (index.row() >= fetchedRows)
+        if (!FetchPage())
+            return boost::any();
+
+    DatabaseRow * row = pages[index.row() / PAGED_QUERY_PAGE_SIZE].GetRow(index.row() % PAGED_QUERY_PAGE_SIZE);
+
+    return row ? GetData(*row, index.column(), role) : boost::any();
+}
+
+boost::any PagedQueryModel::headerData(int section, Wt::Orientation orientation, int role) const
+{
+    if (orientation != Wt::Horizontal || role != Wt::DisplayRole || section < 0 || section >= int(queryColumns.size()))
+        return boost::any();
+
+    return Wt::WString::tr(queryColumns[section].header);
+}
+
+void PagedQueryModel::sort(int column, Wt::SortOrder order)
+{
+    if (column < 0 || column >= int(queryColumns.size()) || queryColumns[column].orderBy.empty())
+        return;
+
+    layoutAboutToBeChanged().emit();
+
+    sortColumn = column;
+    sortOrder = order;
+
+    // rows are read again in new order
+    pages.clear();
+    fetchedRows = 0;
+    fetchedAll = rows == 0;
+
+    layoutChanged().emit();
+}
@@ -0,0 +1,107 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PAGED_QUERY_MODEL_H_INCLUDED
+#define PAGED_QUERY_MODEL_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <Wt/WAbstractTableModel>
+
+#include "database.h"
+#include "defines.h"
+
+#define PAGED_QUERY_PAGE_SIZE   100     /// rows fetched by one query
+
+/********************************************//**
+ * \brief Column of PagedQueryModel.
+ ***********************************************/
+
+struct PagedQueryColumn
+{
+    PagedQueryColumn(const char * header, const char * orderBy = "") : header(header), orderBy(orderBy) {}
+
+    const char * header;                                /// header text id
+    std::string orderBy;                                /// SQL expression used to sort by this column (not NULL values), empty when column can't be sorted
+};
+
+/********************************************//**
+ * \brief Table model which reads character rows page by page.
+ *
+ * Model counts rows on Load() and later fetches only pages
+ * needed by view (WTableView renders only visible rows).
+ * Pages are read with keyset pagination - next page starts
+ * after sort value and key of last fetched row, so db
+ * doesn't need to skip already fetched rows.
+ * Sorting is done by db (ORDER BY column expression and key).
+ *
+ * Load() for already loaded character compares fetched
+ * rows by key with new ones and only changed, inserted
+ * or removed rows are signaled to view.
+ *
+ * Query is built from parts given in constructor:
+ * SELECT columns FROM from WHERE where ... where must
+ * contain one '?' for character guid.
+ *
+ ***********************************************/
+
+class PagedQueryModel : public Wt::WAbstractTableModel
+{
+public:
+    PagedQueryModel(const std::string & columns, const std::string & from, const std::string & where, const std::string & key, Wt::WObject * parent = 0);
+
+    void AddColumn(const PagedQueryColumn & column) { queryColumns.push_back(column); }
+
+    int Load(int realm, uint64 guid);                   /// counts rows (pages are fetched by data()), returns rows count, DB_RESULT_EMPTY or DB_RESULT_ERROR
+                                                        /// for same character only differences from previous load are signaled
+    void Clear();                                       /// removes all rows
+
+    int columnCount(const Wt::WModelIndex & parent = Wt::WModelIndex()) const;
+    int rowCount(const Wt::WModelIndex & parent = Wt::WModelIndex()) const;
+    boost::any data(const Wt::WModelIndex & index, int role = Wt::DisplayRole) const;
+    boost::any headerData(int section, Wt::Orientation orientation = Wt::Horizontal, int role = Wt::DisplayRole) const;
+    void sort(int column, Wt::SortOrder order = Wt::AscendingOrder);
+
+protected:
+    virtual boost::any GetData(const DatabaseRow & row, int column, int role) const = 0; /// returns cell data from fetched row (fields are in same order as in columns)
+
+private:
+    bool FetchPage() const;                             /// fetches next page, returns false when there are no more rows
+    void Refresh(int count);                            /// reads again fetched rows and signals differences, count is new rows count
+    std::string GetOrderBy() const;                     /// returns sort expression of current sort column
+
+    std::string columns;
+    std::string from;
+    std::string where;
+    std::string key;                                    /// unique (for character) column used as tie breaker
+
+    std::vector<PagedQueryColumn> queryColumns;
+
+    int realm;
+    uint64 guid;
+    int rows;                                           /// rows count from Load()
+    int sortColumn;                                     /// -1 for key order
+    Wt::SortOrder sortOrder;
+
+    // pages are fetched on view request
+    mutable std::vector<DatabaseResult> pages;
+    mutable int fetchedRows;
+    mutable bool fetchedAll;
+};
+
+#endif // PAGED_QUERY_MODEL_H_INCLUDED
@@ -29,6 +29,9 @@
 
 #include "accInfo.h"
 
+#include <memory>
+#include <string>
+
 #include <Wt/WBreak>
 #include <Wt/WPushButton>
 #include <Wt/WStackedWidget>
@@ -38,6 +41,7 @@
 
 #include "../config.h"
 #include "../database.h"
+#include "../databaseExecutor.h"
 #include "../misc.h"
 #include "../miscAccount.h"
 #include "../miscClient.h"
@@ -56,6 +60,8 @@ AccountInfoPage::AccountInfoPage(SessionInfo * sess, WContainerWidget * parent)
 {
     session = sess;
     needCreation = true;
+    updating = false;
+    version = 0;
 
     setStyleClass("page accountwidget");
 }
@@ -142,6 +148,8 @@ void AccountInfoPage::UpdateInformations()
  * \brief Update Basic Account Informations widgets.
  *
  * Only informations update. There is no need to delete old and create new widgets.
+ * Informations from DB are loaded by DB executor, widgets are updated
+ * when loading is done (loading info is shown meanwhile).
  *
  ***********************************************/
 
@@ -163,84 +171,168 @@ void AccountInfoPage::UpdateAccountInfo(bool first)
         return;
     }
 
+    // previous update is still executed
+    if (updating)
+        return;
+
+    updating = true;
+    accPageInfo->setText(Wt::WString::tr(TXT_GEN_LOADING));
+
+    // queries are executed by DB executor and widgets are updated when they are done
+    std::shared_ptr<AccountInfoData> data = std::make_shared<AccountInfoData>();
+    uint64 accountId = session->accountId;
+    std::string lastIp = session->lastIp.toUTF8();
+    std::string sessionIp = session->sessionIp.toUTF8();
+    uint32 pageVersion = version;
+
+    bool posted = sDatabaseExecutor.Post(
+        [data, accountId, lastIp, sessionIp]()
+        {
+            LoadAccountInfo(*data, accountId, lastIp, sessionIp);
+        },
+        [this, data, pageVersion]()
+        {
+            // page was cleared meanwhile (for example on logout)
+            if (pageVersion != version)
+                return;
+
+            updating = false;
+            ShowAccountInfo(*data);
+        });
+
+    if (!posted)
+    {
+        updating = false;
+        accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+    }
+}
+
+/********************************************//**
+ * \brief Loads Basic Account Informations from DB.
+ *
+ * \param data       Structure which will be filled with informations.
+ * \param accountId  Account id.
+ * \param lastIp     Last IP used to log in on server.
+ * \param sessionIp  Current session IP.
+ *
+ * This function is executed outside of session by DB executor
+ * so it can't use any widgets or session data.
+ *
+ ***********************************************/
+
+void AccountInfoPage::LoadAccountInfo(AccountInfoData & data, uint64 accountId, const std::string & lastIp, const std::string & sessionIp)
+{
     Database realmDb;
 
     if (!realmDb.Connect(DB_ACCOUNTS_DATA))
     {
-        accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
+        data.error = TXT_ERROR_DB_CANT_CONNECT;
+        return;
+    }
+
+    // all informations are loaded in one round trip (batch can't use prepared statements, uint64 is formatted as string for all platforms)
+    std::vector<std::string> queries;
+                                                          //     0         1         2         3          4            5             6
+    queries.push_back(Misc::GetFormattedString("SELECT account_id, last_ip, last_login, online, expansion_id, locale_id, account_state.name "
+                                               "FROM account JOIN account_state ON account.account_state_id = account_state.account_state_id "
+                                               "WHERE account_id = %s", std::to_string(accountId).c_str()));
+    queries.push_back(Misc::GetFormattedString("SELECT reason FROM account_punishment "
+                                               "WHERE account_id = %s "
+                                               "     AND punishment_type_id = %u "
+                                               "     AND (punishment_date = expiration_date OR expiration_date > UNIX_TIMESTAMP()) "
+                                               "ORDER BY expiration_date DESC", std::to_string(accountId).c_str(), PUNISHMENT_BAN));
+    queries.push_back(Misc::GetFormattedString("SELECT ban_reason FROM ip_banned WHERE ip = '%s' AND (ban_date = unban_date OR unban_date > UNIX_TIMESTAMP())",
+                                               realmDb.EscapeString(lastIp).c_str()));
+    queries.push_back(Misc::GetFormattedString("SELECT ban_reason FROM ip_banned WHERE ip = '%s' AND (ban_date = unban_date OR unban_date > UNIX_TIMESTAMP())",
+                                               realmDb.EscapeString(sessionIp).c_str()));
+
+    // there should be only one account record in db
+    if (realmDb.ExecuteBatch(queries) == DB_RESULT_ERROR || !realmDb.GetBatchResult(0)->GetRowsCount())
+    {
+        data.error = TXT_ERROR_DB_QUERY_ERROR;
         return;
     }
 
-    DatabaseRow * tmpRow;
-                    //             0         1         2         3          4            5             6
-    realmDb.SetPQuery("SELECT account_id, last_ip, last_login, online, expansion_id, locale_id, account_state.name "
-                      "FROM account JOIN account_state ON account.account_state_id = account_state.account_state_id "
-                      "WHERE account_id = '%u'", session->accountId);
+    DatabaseRow * tmpRow = realmDb.GetBatchResult(0)->GetRow(0);
+
+    data.lastIp = tmpRow->fields[1].GetString();
+    data.lastLogin = tmpRow->fields[2].GetString();
+    data.online = tmpRow->fields[3].GetBool();
+    data.expansion = tmpRow->fields[4].GetInt();
+    data.locale = tmpRow->fields[5].GetInt();
+    data.state = tmpRow->fields[6].GetString();
 
-    // there should be only one record in db
-    if (realmDb.ExecuteQuery() > DB_RESULT_EMPTY)
+    if ((tmpRow = realmDb.GetBatchResult(1)->GetRow(0)))
     {
-        tmpRow = realmDb.GetRow();
+        data.banned = true;
+        data.banReason = tmpRow->fields[0].GetString();
+    }
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_TYPE, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(Misc::Client::GetExpansionName(tmpRow->fields[4].GetInt()));
+    data.lastIpBanned = realmDb.GetBatchResult(2)->GetRowsCount() > 0;
+    data.currIpBanned = realmDb.GetBatchResult(3)->GetRowsCount() > 0;
+}
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_LOGIN_DATE, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(tmpRow->fields[2].GetWString());
+/********************************************//**
+ * \brief Shows loaded Basic Account Informations.
+ *
+ * \param data   Informations loaded by LoadAccountInfo.
+ *
+ ***********************************************/
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_LOGGED_IP, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(tmpRow->fields[1].GetWString());
+void AccountInfoPage::ShowAccountInfo(const AccountInfoData & data)
+{
+    if (data.error)
+    {
+        accPageInfo->setText(Wt::WString::tr(data.error));
+        return;
+    }
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_STATE, 1)->widget(0);
-        ((WPushButton*)tmpWidget)->setText(tmpRow->fields[6].GetWString());
+    // errors set by other loaders meanwhile are kept, only loading info is removed
+    if (accPageInfo->text() == Wt::WString::tr(TXT_GEN_LOADING))
+        accPageInfo->setText("");
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_ONLINE, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(Wt::WString::tr(tmpRow->fields[3].GetBool() ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE));
+    WWidget * tmpWidget = NULL;
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_CLIENT_VERSION, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(Misc::Client::GetLocale(tmpRow->fields[5].GetInt()));
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_TYPE, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Misc::Client::GetExpansionName(data.expansion));
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_VOTE_POINTS, 1)->widget(0);
-        ((WText*)tmpWidget)->setText(Misc::GetFormattedString("%u", session->supportPoints));
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_LOGIN_DATE, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(WString::fromUTF8(data.lastLogin));
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_XP_RATE, 1)->widget(0);
-        ((WPushButton*)tmpWidget)->setText(Wt::WString::tr(session->accountFlags & 0x0008 ? TXT_XP_RATE_BLIZZLIKE : TXT_XP_RATE_SERVER));
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_LOGGED_IP, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(WString::fromUTF8(data.lastIp));
 
-/*
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_MULTIACC, 1)->widget(0);
-        ((WText*)tmpWidget)->setText();
-*/
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_STATE, 1)->widget(0);
+    ((WPushButton*)tmpWidget)->setText(WString::fromUTF8(data.state));
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_ACC_BAN, 1)->widget(0);
-        realmDb.SetPQuery("SELECT reason FROM account_punishment "
-                          "WHERE account_id = '%u' "
-                          "     AND punishment_type = '%u' "
-                          "     AND (punishment_date == expiration_date OR expiration_date > UNIX_TIMESTAMP()) "
-                          "ORDER BY expiration_date DESC", session->accountId, PUNISHMENT_BAN);
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_ONLINE, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Wt::WString::tr(data.online ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE));
 
-        if (realmDb.ExecuteQuery() > DB_RESULT_EMPTY)
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_PUNISHMENT_BANNED).arg(realmDb.GetRow()->fields[0].GetWString()));
-        else
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_NO));
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_CLIENT_VERSION, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Misc::Client::GetLocale(data.locale));
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_IP_BAN, 1)->widget(0);
-        realmDb.SetPQuery("SELECT ban_reason FROM ip_banned WHERE ip = '%s' AND (ban_date == unban_date OR unban_date > UNIX_TIMESTAMP())", session->lastIp.toUTF8().c_str());
-        if (realmDb.ExecuteQuery() > DB_RESULT_EMPTY)
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_YES));
-        else
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_NO));
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_VOTE_POINTS, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Misc::GetFormattedString("%u", session->supportPoints));
 
-        tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_CURR_IP_BAN, 1)->widget(0);
-        realmDb.SetPQuery("SELECT ban_reason FROM ip_banned WHERE ip = '%s' AND (ban_date == unban_date OR unban_date > UNIX_TIMESTAMP())", session->sessionIp.toUTF8().c_str());
-        if (realmDb.ExecuteQuery() > DB_RESULT_EMPTY)
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_YES));
-        else
-            ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_NO));
-    }
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_XP_RATE, 1)->widget(0);
+    ((WPushButton*)tmpWidget)->setText(Wt::WString::tr(session->accountFlags & 0x0008 ? TXT_XP_RATE_BLIZZLIKE : TXT_XP_RATE_SERVER));
+
+/*
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_MULTIACC, 1)->widget(0);
+    ((WText*)tmpWidget)->setText();
+*/
+
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_ACC_BAN, 1)->widget(0);
+    if (data.banned)
+        ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_PUNISHMENT_BANNED).arg(WString::fromUTF8(data.banReason)));
     else
-        accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+        ((WText*)tmpWidget)->setText(Wt::WString::tr(TXT_GEN_NO));
 
-    tmpRow = NULL;
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_LAST_IP_BAN, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Wt::WString::tr(data.lastIpBanned ? TXT_GEN_YES : TXT_GEN_NO));
+
+    tmpWidget = accountInfo->elementAt(ACCINFO_SLOT_CURR_IP_BAN, 1)->widget(0);
+    ((WText*)tmpWidget)->setText(Wt::WString::tr(data.currIpBanned ? TXT_GEN_YES : TXT_GEN_NO));
 }
 
 /********************************************//**
@@ -419,6 +511,10 @@ void AccountInfoPage::ClearPage()
 
     needCreation = true;
 
+    // results of currently executed update shouldn't be shown
+    updating = false;
+    ++version;
+
     clear();
 
     // NULL pointers
@@ -467,8 +563,7 @@ void AccountInfoPage::ChangeIPLock()
     else
        accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
 
-    if (db.Connect(DB_PANEL_DATA))
-        db.ExecutePQuery("INSERT INTO Activity VALUES ('%u', NOW(), '%s', '%s', '')", session->accountId, session->sessionIp.toUTF8().c_str(), TXT_ACT_IP_LOCK);
+    Misc::Account::AddActivity(session->accountId, session->sessionIp.toUTF8(), TXT_ACT_IP_LOCK, "");
 }
 
 /********************************************//**
@@ -542,12 +637,10 @@ WTable * AccountInfoPage::CreatePunishmentInfo()
         return banInfo;
     }
 
-    realmDB.SetPQuery("SELECT FROM_UNIXTIME(punishment_date), FROM_UNIXTIME(expiration_date), punished_by, reason, punishment_type.name, (punishment_date = expiration_date), (punishment_date = expiration_date OR expiration_date > UNIX_TIMESTAMP()) "
-                      "FROM account_punishment JOIN punishment_type ON account_punishment.punishment_type_id = punishment_type.punishment_type_id "
-                      "WHERE account_id = %u "
-                      "ORDER BY expiration_date DESC", session->accountId);
-
-    switch (realmDB.ExecuteQuery())
+    switch (realmDB.ExecuteStatement("SELECT FROM_UNIXTIME(punishment_date), FROM_UNIXTIME(expiration_date), punished_by, reason, punishment_type.name, (punishment_date = expiration_date), (punishment_date = expiration_date OR expiration_date > UNIX_TIMESTAMP()) "
+                                     "FROM account_punishment JOIN punishment_type ON account_punishment.punishment_type_id = punishment_type.punishment_type_id "
+                                     "WHERE account_id = ? "
+                                     "ORDER BY expiration_date DESC", DatabaseParams().AddUInt64(session->accountId)))
     {
         case DB_RESULT_ERROR:
             accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
@@ -558,16 +651,16 @@ WTable * AccountInfoPage::CreatePunishmentInfo()
         default:
             {
                 int i = 1, j;
-                std::list<DatabaseRow*> rows = realmDB.GetRows();
+                const std::vector<DatabaseRow> & rows = realmDB.GetRows();
                 realmDB.Disconnect();
 
-                for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
+                for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
                 {
                     for (j = 0; j < 5; ++j)
-                        banInfo->elementAt(i, j)->addWidget(new WText((*itr)->fields[j].GetWString()));
+                        banInfo->elementAt(i, j)->addWidget(new WText(itr->fields[j].GetWString()));
 
-                    banInfo->elementAt(i, 5)->addWidget(new WText(Wt::WString::tr((*itr)->fields[5].GetBool() ? TXT_GEN_PERM : TXT_GEN_TIMED)));
-                    banInfo->elementAt(i, 6)->addWidget(new WText(Wt::WString::tr((*itr)->fields[6].GetBool() ? TXT_GEN_ACTIVE : TXT_GEN_NOT_ACTIVE)));
+                    banInfo->elementAt(i, 5)->addWidget(new WText(Wt::WString::tr(itr->fields[5].GetBool() ? TXT_GEN_PERM : TXT_GEN_TIMED)));
+                    banInfo->elementAt(i, 6)->addWidget(new WText(Wt::WString::tr(itr->fields[6].GetBool() ? TXT_GEN_ACTIVE : TXT_GEN_NOT_ACTIVE)));
                 }
             }
             break;
@@ -606,78 +699,68 @@ WContainerWidget * AccountInfoPage::CreateActivityInfo()
     tabServer->elementAt(0, 0)->addWidget(new WText(Wt::WString::tr(TXT_ACT_DATE)));
     tabServer->elementAt(0, 1)->addWidget(new WText(Wt::WString::tr(TXT_ACT_IP)));
 
-    // fill tables
+    // fill tables, rows are added to tables directly from streamed results
     Database db;
+    DatabaseCursor cursor;
+    const DatabaseRow * tmpRow;
     int i;
 
     if (db.Connect(DB_PANEL_DATA))
     {
-        db.SetPQuery("SELECT event_date, ip, activity_id, activity_args FROM Activity WHERE account_id = %u ORDER BY event_date DESC LIMIT %i", session->accountId, sConfig.GetConfig(CONFIG_ACTIVITY_LIMIT_PANEL));
-
-        switch (db.ExecuteQuery())
+        // cursor reads text query results, account id is formatted by std::to_string (uint64 format differs between platforms)
+        if (db.ExecuteStreamQuery("SELECT event_date, ip, activity_id, activity_args FROM Activity WHERE account_id = " + std::to_string(session->accountId) +
+                                  " ORDER BY event_date DESC LIMIT " + std::to_string(sConfig.GetConfig(CONFIG_ACTIVITY_LIMIT_PANEL)), cursor))
         {
-            case DB_RESULT_ERROR:
-                accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-                break;
-            case DB_RESULT_EMPTY:
-                break;
-            default:
+            for (i = 1; cursor.Next(); ++i)
             {
-                DatabaseRow * tmpRow;
-                std::list<DatabaseRow*> rows = db.GetRows();
-                db.Disconnect();
-                i = 1;
-
-                for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
-                {
-                    tmpRow = *itr;
+                tmpRow = cursor.GetRow();
 
-                    std::string txtId = tmpRow->fields[2].GetString();
-                    WString txt = tmpRow->fields[3].GetWString();
+                std::string txtId = tmpRow->fields[2].GetString();
+                WString txt = tmpRow->fields[3].GetWString();
 
-                    tabPanel->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
-                    tabPanel->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
+                tabPanel->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
+                tabPanel->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
 
-                    if (!txtId.empty())
-                    {
-                        if (txt != "")
-                            tabPanel->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(txtId).arg(txt)));
-                        else
-                            tabPanel->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(txtId)));
-                    }
+                if (!txtId.empty())
+                {
+                    if (txt != "")
+                        tabPanel->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(txtId).arg(txt)));
                     else
-                        tabPanel->elementAt(i, 2)->addWidget(new WText(txt));
+                        tabPanel->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(txtId)));
                 }
+                else
+                    tabPanel->elementAt(i, 2)->addWidget(new WText(txt));
             }
+
+            if (cursor.HasError())
+                accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
         }
+        else
+            accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+
+        db.Disconnect();
     }
 
     if (db.Connect(DB_ACCOUNTS_DATA))
     {
-        db.SetPQuery("SELECT logindate, ip FROM account_login WHERE id = %u ORDER BY logindate DESC LIMIT %i", session->accountId, sConfig.GetConfig(CONFIG_ACTIVITY_LIMIT_SERVER));
-
-        switch (db.ExecuteQuery())
+        if (db.ExecuteStreamQuery("SELECT logindate, ip FROM account_login WHERE id = " + std::to_string(session->accountId) +
+                                  " ORDER BY logindate DESC LIMIT " + std::to_string(sConfig.GetConfig(CONFIG_ACTIVITY_LIMIT_SERVER)), cursor))
         {
-            case DB_RESULT_ERROR:
-                accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-                break;
-            case DB_RESULT_EMPTY:
-                break;
-            default:
+            for (i = 1; cursor.Next(); ++i)
             {
-                DatabaseRow * tmpRow;
-                std::list<DatabaseRow*> rows = db.GetRows();
-                db.Disconnect();
-                i = 1;
+                tmpRow = cursor.GetRow();
 
-                for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
-                {
-                    tmpRow = *itr;
-                    tabServer->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
-                    tabServer->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
-                }
+                tabServer->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
+                tabServer->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
             }
+
+            if (cursor.HasError())
+                accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
         }
+        else
+            accPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+
+        db.Disconnect();
     }
 
     return activityInfo;
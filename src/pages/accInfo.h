@@ -104,6 +104,34 @@ enum AccInfoTabSlot
     ACCTAB_SLOT_COUNT
 };
 
+/********************************************//**
+ * \brief Basic account informations loaded in background.
+ *
+ * Filled by DB executor thread so it contains
+ * only plain data - texts are translated when
+ * informations are shown.
+ *
+ ***********************************************/
+
+struct AccountInfoData
+{
+    AccountInfoData() : error(NULL), online(false), expansion(0), locale(0), banned(false), lastIpBanned(false), currIpBanned(false) {}
+
+    const char * error;         /**< Text id of error which occured or NULL. */
+
+    std::string lastIp;         /**< Last IP used to log in on server. */
+    std::string lastLogin;      /**< Last login date. */
+    std::string state;          /**< Account state name. */
+    bool online;                /**< Account is online on server. */
+    int expansion;              /**< Account expansion. */
+    int locale;                 /**< Client locale. */
+
+    bool banned;                /**< Account is banned. */
+    std::string banReason;      /**< Reason of account ban. */
+    bool lastIpBanned;          /**< Last IP is banned. */
+    bool currIpBanned;          /**< Current IP is banned. */
+};
+
 /********************************************//**
  * \brief A class to represents Account Informations page
  *
@@ -130,6 +158,10 @@ private:
     bool needCreation;
     /// account page additional info
     WText * accPageInfo;
+    /// account informations are loaded in background
+    bool updating;
+    /// increased when page content is cleared - results of older updates are ignored
+    uint32 version;
 
     void UpdateInformations();
 
@@ -138,6 +170,8 @@ private:
     Wt::WTable * accountInfo;
     WContainerWidget * CreateAccountInfo();
     void UpdateAccountInfo(bool first = false);
+    static void LoadAccountInfo(AccountInfoData & data, uint64 accountId, const std::string & lastIp, const std::string & sessionIp);
+    void ShowAccountInfo(const AccountInfoData & data);
 
     WTable * CreatePunishmentInfo();
 
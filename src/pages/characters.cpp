@@ -29,23 +29,29 @@
 
 #include "characters.h"
 
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <unordered_map>
+
+#include <Wt/WApplication>
 #include <Wt/WBreak>
 #include <Wt/WComboBox>
 #include <Wt/WLineF>
 #include <Wt/WPushButton>
 #include <Wt/WStackedWidget>
 #include <Wt/WTable>
+#include <Wt/WTableView>
 #include <Wt/WTabWidget>
 #include <Wt/WText>
 
 #include "../config.h"
 #include "../database.h"
+#include "../itemInstanceData.h"
 #include "../misc.h"
 #include "../miscAccount.h"
 #include "../miscCharacter.h"
-
-bool CharacterInfoPage::spellsLoaded = false;
-std::map<uint32, SpellInfo> CharacterInfoPage::spells;
+#include "../spellDictionary.h"
 
 MailInfo::MailInfo(const MailInfo & mi)
 {
@@ -57,6 +63,8 @@ MailInfo::MailInfo(const MailInfo & mi)
     deliverTime = mi.deliverTime;
     expireTime = mi.expireTime;
     text = mi.text;
+    textId = mi.textId;
+    textLoaded = mi.textLoaded;
     money = mi.money;
     cod = mi.cod;
     checkMask = mi.checkMask;
@@ -74,44 +82,65 @@ MailInfo::MailInfo(const DatabaseRow * row)
     subject = row->fields[4].GetWString();
     deliverTime = row->fields[5].GetWString();
     expireTime = row->fields[6].GetWString();
-    text = row->fields[7].GetWString();
+    textId = row->fields[7].GetUInt32();
+    textLoaded = textId == 0;
     money = row->fields[8].GetUInt32();
     cod = row->fields[9].GetUInt32();
     checkMask = row->fields[10].GetUInt32();
 }
 
 /********************************************//**
- * \brief Loads items to mail from given database row list.
+ * \brief Adds item attached to this mail.
  *
- * \param mailItems list contains database result with all mailed items to given character
+ * \param row  mail items query row (mail_id, item_template, name, data, item_guid)
+ ***********************************************/
+
+void MailInfo::AddItem(const DatabaseRow * row)
+{
+    Item tmpItem;
+    tmpItem.id = row->fields[1].GetUInt32();
+    tmpItem.name = row->fields[2].GetWString();
+    tmpItem.stackCount = ItemInstanceData(row->fields[3]).GetStackCount();
+    tmpItem.guid = row->fields[4].GetUInt32();
+
+    items.push_back(tmpItem);
+}
+
+/********************************************//**
+ * \brief Loads mail body.
  *
- * Funcion iterates on given mail items list. When item attached to this mail will be found
- * function will store it's data and item will be removed from mail items list.
+ * \param realm  realm id of mail receiver
+ *
+ * Mails list contains only headers, body is read when mail is previewed
+ * for the first time. On error body stays empty and will be read again.
  ***********************************************/
 
-void MailInfo::LoadItems(std::list<DatabaseRow*> & mailItems)
+void MailInfo::LoadBody(int realm)
 {
-    // process all currently loaded mail items
-    for (std::list<DatabaseRow*>::iterator itr = mailItems.begin(); itr != mailItems.end();)
-    {
-        std::list<DatabaseRow*>::iterator tmpItr = itr;
-        ++itr;
-        DatabaseRow * tmpRow = *tmpItr;
+    if (textLoaded)
+        return;
 
-        // if it's item from this mail get store his data and remove from loaded mail items list
-        if (tmpRow->fields[0].GetUInt64() == id)
-        {
-            Item tmpItem;
-            tmpItem.id = tmpRow->fields[1].GetUInt32();
-            tmpItem.name = tmpRow->fields[2].GetWString();
-            tmpItem.stackCount = tmpRow->fields[3].GetUInt32();
-            tmpItem.guid = tmpRow->fields[4].GetUInt32();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 
-            items.push_back(tmpItem);
+    Database db;
+    if (!db.Connect(DB_REALM_DATA(realm)))
+        return;
 
-            mailItems.erase(tmpItr);
-        }
+    switch (db.ExecuteStatement("SELECT text FROM item_text WHERE id = ?", DatabaseParams().AddUInt32(textId)))
+    {
+        case DB_RESULT_ERROR:
+            return;
+        case DB_RESULT_EMPTY:
+            break;
+        default:
+            text = db.GetRow()->fields[0].GetWString();
+            break;
     }
+
+    textLoaded = true;
+
+    Misc::Console(DEBUG_CODE, "MailInfo::LoadBody(): mail %u body loaded in %u ms\n", uint32(id),
+                  uint32(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()));
 }
 
 /********************************************//**
@@ -147,8 +176,106 @@ Wt::WString MailInfo::GetFrom() const
  *
  ***********************************************/
 
+// views render only visible rows, so they need fixed height
+#define CHARACTER_TABLE_HEIGHT  400
+
+CharacterQuestsModel::CharacterQuestsModel(Wt::WObject * parent)
+: PagedQueryModel("cq.quest, qt.Name, qt.QuestLevel, cq.status, cq.rewarded, qt.MinLevel",
+                  "character_queststatus AS cq JOIN world.quest_template AS qt ON cq.quest = qt.entry", // TODO: fix world join
+                  Misc::GetFormattedString("cq.guid = ? AND qt.Type <> %i", QUEST_TYPE_DAILY), "cq.quest", parent)
+{
+    AddColumn(PagedQueryColumn(TXT_QUEST_NAME, "qt.Name"));
+    AddColumn(PagedQueryColumn(TXT_QUEST_LVL, "qt.QuestLevel"));
+    // rewarded quests are after all others
+    AddColumn(PagedQueryColumn(TXT_QUEST_STATUS, "cq.rewarded * 16 + cq.status"));
+}
+
+Wt::WFlags<Wt::ItemFlag> CharacterQuestsModel::flags(const Wt::WModelIndex & index) const
+{
+    // name is link to quest in db
+    if (index.column() == CHARQUESTINFO_SLOT_NAME)
+        return Wt::ItemIsSelectable | Wt::ItemIsXHTMLText;
+
+    return Wt::ItemIsSelectable;
+}
+
+boost::any CharacterQuestsModel::GetData(const DatabaseRow & row, int column, int role) const
+{
+    switch (column)
+    {
+        case CHARQUESTINFO_SLOT_NAME:
+            if (role == Wt::DisplayRole)
+                return Wt::WString::tr(TXT_QUEST_LINK_NAME_FMT).arg(row.fields[0].GetInt()).arg(row.fields[1].GetCString());
+            if (role == Wt::ToolTipRole)
+                return Wt::WString::tr(TXT_QUEST_TOOLTIP_FMT).arg(row.fields[0].GetInt()).arg(row.fields[5].GetInt());
+            break;
+        case CHARQUESTINFO_SLOT_LEVEL:
+            if (role == Wt::DisplayRole)
+                return row.fields[2].GetWString();
+            break;
+        case CHARQUESTINFO_SLOT_STATUS:
+            if (role == Wt::DisplayRole)
+                return Misc::Character::GetQuestStatus(row.fields[3].GetInt(), row.fields[4].GetBool());
+            break;
+    }
+
+    return boost::any();
+}
+
+CharacterSpellsModel::CharacterSpellsModel(Wt::WObject * parent)
+: PagedQueryModel("spell, active, disabled", "character_spell", "guid = ?", "spell", parent)
+{
+    AddColumn(PagedQueryColumn(TXT_SPELL_ID, "spell"));
+    AddColumn(PagedQueryColumn(TXT_SPELL_NAME));
+    AddColumn(PagedQueryColumn(TXT_SPELL_ACTIVE, "active"));
+    AddColumn(PagedQueryColumn(TXT_SPELL_DISABLED, "disabled"));
+}
+
+boost::any CharacterSpellsModel::GetData(const DatabaseRow & row, int column, int role) const
+{
+    if (role != Wt::DisplayRole)
+        return boost::any();
+
+    switch (column)
+    {
+        case CHARSPELLINFO_SLOT_ID:
+            return row.fields[0].GetWString();
+        case CHARSPELLINFO_SLOT_NAME:
+            return spells ? spells->GetName(row.fields[0].GetUInt32()) : Wt::WString();
+        case CHARSPELLINFO_SLOT_ACTIVE:
+            return Wt::WString::tr(row.fields[1].GetBool() ? TXT_GEN_YES : TXT_GEN_NO);
+        case CHARSPELLINFO_SLOT_DISABLED:
+            return Wt::WString::tr(row.fields[2].GetBool() ? TXT_GEN_YES : TXT_GEN_NO);
+    }
+
+    return boost::any();
+}
+
+CharacterInventoryModel::CharacterInventoryModel(Wt::WObject * parent)
+: PagedQueryModel("ci.item_template, it.name, ii.`data`",
+                  "character_inventory AS ci JOIN item_instance AS ii ON ci.item = ii.guid JOIN world.item_template AS it ON ci.item_template = it.entry", // TODO: fix world join
+                  "ci.guid = ?", "ci.item", parent)
+{
+    AddColumn(PagedQueryColumn(TXT_ITEM_ID, "ci.item_template"));
+    AddColumn(PagedQueryColumn(TXT_ITEM_NAME, "it.name"));
+    // count is stored inside ii.`data`, sorting by it would parse data of every item in query
+    AddColumn(PagedQueryColumn(TXT_ITEM_COUNT));
+}
+
+boost::any CharacterInventoryModel::GetData(const DatabaseRow & row, int column, int role) const
+{
+    if (role != Wt::DisplayRole || column < 0 || column >= CHARINVINFO_SLOT_COUNT)
+        return boost::any();
+
+    if (column == CHARINVINFO_SLOT_STACK)
+        return Wt::WString::fromUTF8(Misc::GetFormattedString("%u", ItemInstanceData(row.fields[column]).GetStackCount()));
+
+    return row.fields[column].GetWString();
+}
+
 CharacterInfoPage::CharacterInfoPage(SessionInfo * sess, WContainerWidget * parent) :
-    WContainerWidget(parent), restoreCharacter(NULL), restoring(false)
+    WContainerWidget(parent), restoreCharacter(NULL), currentGuid(0), infoTab(-1), restoring(false),
+    questModel(NULL), spellModel(NULL), inventoryModel(NULL)
 {
     session = sess;
 
@@ -203,6 +330,7 @@ void CharacterInfoPage::refresh()
             tabs->addTab(CreateCharacterInventoryInfo(), Wt::WString::tr(TXT_CHAR_TAB_INVENTORY)/*, WTabWidget::PreLoading*/);
             tabs->addTab(CreateCharacterFriendInfo(), Wt::WString::tr(TXT_CHAR_TAB_FRIENDS)/*, WTabWidget::PreLoading*/);
             tabs->addTab(CreateCharacterMailInfo(), Wt::WString::tr(TXT_CHAR_TAB_MAIL));
+            tabs->currentChanged().connect(this, &CharacterInfoPage::TabChanged);
 
             charList->clear();
             indexToCharInfo.clear();
@@ -214,7 +342,7 @@ void CharacterInfoPage::refresh()
             }
 
             int index = 0;
-            switch (db.ExecutePQuery("SELECT guid, account, name, race FROM characters WHERE account = '%u'", session->accountId))
+            switch (db.ExecuteStatement("SELECT guid, account, name, race FROM characters WHERE account = ?", DatabaseParams().AddUInt64(session->accountId)))
             {
                 case DB_RESULT_ERROR:
                     charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
@@ -223,12 +351,12 @@ void CharacterInfoPage::refresh()
                     break;
                 default:
 
-                    std::list<DatabaseRow*> rows = db.GetRows();
-                    DatabaseRow * tmpRow;
+                    const std::vector<DatabaseRow> & rows = db.GetRows();
+                    const DatabaseRow * tmpRow;
 
-                    for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+                    for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
                     {
-                        tmpRow = *itr;
+                        tmpRow = &*itr;
 
                         CharInfo tmpCharInfo(tmpRow->fields[0].GetUInt64(), tmpRow->fields[1].GetUInt32(), tmpRow->fields[2].GetWString(), tmpRow->fields[3].GetInt(), false);
 
@@ -238,17 +366,17 @@ void CharacterInfoPage::refresh()
                     break;
             }
 
-            if (db.ExecutePQuery("SELECT char_guid, acc, oldname, race, date "
-                                 "FROM deleted_chars JOIN characters ON deleted_chars.char_guid = characters.guid "
-                                 "WHERE acc = '%u'", session->accountId) > DB_RESULT_EMPTY)
+            if (db.ExecuteStatement("SELECT char_guid, acc, oldname, race, date "
+                                    "FROM deleted_chars JOIN characters ON deleted_chars.char_guid = characters.guid "
+                                    "WHERE acc = ?", DatabaseParams().AddUInt64(session->accountId)) > DB_RESULT_EMPTY)
             {
 
-                std::list<DatabaseRow*> rows = db.GetRows();
-                DatabaseRow * tmpRow;
+                const std::vector<DatabaseRow> & rows = db.GetRows();
+                const DatabaseRow * tmpRow;
 
-                for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+                for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
                 {
-                    tmpRow = *itr;
+                    tmpRow = &*itr;
 
                     CharInfo tmpCharInfo;
                     tmpCharInfo.guid = tmpRow->fields[0].GetUInt64();
@@ -269,6 +397,17 @@ void CharacterInfoPage::refresh()
             db.Disconnect();
         }
 
+        // race, class and quest status names are resolved for locale, so tabs are loaded again when it changes
+        if (wApp->locale().name() != namesLocale)
+        {
+            namesLocale = wApp->locale().name();
+
+            for (int i = 0; i < CHAR_TAB_COUNT; ++i)
+                tabStates[i] = CharTabState();
+
+            questModel->Clear();
+        }
+
         std::map<int, CharInfo>::const_iterator tmpItr = indexToCharInfo.find(charList->currentIndex());
         if (tmpItr != indexToCharInfo.end())
             UpdateInformations(tmpItr->second.guid);
@@ -282,9 +421,8 @@ void CharacterInfoPage::refresh()
 /********************************************//**
  * \brief Update character informations.
  *
- * Function updates all informations of currenly selected character, but only
- * if update interval will be greater than configured in config file (or will be forced).
- * Minimum update interval prevents 'over updating character' if there is no need for that.
+ * Function selects character and updates only currently visible tab.
+ * Other tabs are updated when they will be activated.
  *
  ***********************************************/
 
@@ -293,19 +431,83 @@ void CharacterInfoPage::UpdateInformations(uint64 guid, bool force)
     if (!guid)
         return;
 
-    if (!force && lastUpdateTime + sConfig.GetConfig(CONFIG_INTERVAL_UPDATE_CHARACTERS) > std::time(NULL))
+    // messages are related to previously selected character
+    if (guid != currentGuid)
+    {
+        charPageInfo->setText("");
+        infoTab = -1;
+    }
+
+    currentGuid = guid;
+
+    UpdateTab(tabs->currentIndex(), force);
+}
+
+/********************************************//**
+ * \brief Update informations in character tab.
+ *
+ * Tab is updated only when it shows other character or when
+ * update interval will be greater than configured in config file (or will be forced).
+ * Minimum update interval prevents 'over updating character' if there is no need for that.
+ *
+ ***********************************************/
+
+void CharacterInfoPage::UpdateTab(int tab, bool force)
+{
+    if (!currentGuid || tab < 0 || tab >= CHAR_TAB_COUNT)
+        return;
+
+    CharTabState & state = tabStates[tab];
+
+    if (!force && state.guid == currentGuid && state.loadTime + sConfig.GetConfig(CONFIG_INTERVAL_UPDATE_CHARACTERS) > std::time(NULL))
         return;
 
-    charPageInfo->setText("");
+    // only message left by previous load of this tab is removed, messages from other tabs are kept
+    if (infoTab == tab)
+    {
+        charPageInfo->setText("");
+        infoTab = -1;
+    }
+
+    Wt::WString previousInfo = charPageInfo->text();
+    bool loaded = false;
 
-    UpdateCharacterBasicInfo(guid);
-    UpdateCharacterQuestInfo(guid);
-    UpdateCharacterSpellInfo(guid);
-    UpdateCharacterInventoryInfo(guid);
-    UpdateCharacterFriendInfo(guid);
-    UpdateCharacterMailInfo(guid);
+    switch (tab)
+    {
+        case CHAR_TAB_BASIC:
+            loaded = UpdateCharacterBasicInfo(currentGuid);
+            break;
+        case CHAR_TAB_QUEST:
+            loaded = UpdateCharacterQuestInfo(currentGuid);
+            break;
+        case CHAR_TAB_SPELL:
+            loaded = UpdateCharacterSpellInfo(currentGuid);
+            break;
+        case CHAR_TAB_INVENTORY:
+            loaded = UpdateCharacterInventoryInfo(currentGuid);
+            break;
+        case CHAR_TAB_FRIENDS:
+            loaded = UpdateCharacterFriendInfo(currentGuid);
+            break;
+        case CHAR_TAB_MAILS:
+            loaded = UpdateCharacterMailInfo(currentGuid);
+            break;
+    }
+
+    if (charPageInfo->text() != previousInfo)
+        infoTab = tab;
 
-    lastUpdateTime = std::time(NULL);
+    // failed tab is loaded again on next activation
+    if (!loaded)
+        return;
+
+    state.guid = currentGuid;
+    state.loadTime = std::time(NULL);
+}
+
+void CharacterInfoPage::TabChanged(int tab)
+{
+    UpdateTab(tab);
 }
 
 /********************************************//**
@@ -371,15 +573,18 @@ WContainerWidget * CharacterInfoPage::CreateCharacterBasicInfo()
  *
  ***********************************************/
 
-WTable * CharacterInfoPage::CreateCharacterQuestInfo()
+Wt::WTableView * CharacterInfoPage::CreateCharacterQuestInfo()
 {
-    WTable * tmpQuest = new WTable();
+    Wt::WTableView * tmpQuest = new Wt::WTableView();
 
-    tmpQuest->setHeaderCount(1);
+    questModel = new CharacterQuestsModel(tmpQuest);
 
-    tmpQuest->elementAt(0, CHARQUESTINFO_SLOT_NAME)->addWidget(new WText(Wt::WString::tr(TXT_QUEST_NAME)));
-    tmpQuest->elementAt(0, CHARQUESTINFO_SLOT_LEVEL)->addWidget(new WText(Wt::WString::tr(TXT_QUEST_LVL)));
-    tmpQuest->elementAt(0, CHARQUESTINFO_SLOT_STATUS)->addWidget(new WText(Wt::WString::tr(TXT_QUEST_STATUS)));
+    tmpQuest->setModel(questModel);
+    tmpQuest->setAlternatingRowColors(true);
+    tmpQuest->setColumnWidth(CHARQUESTINFO_SLOT_NAME, 300);
+    tmpQuest->setColumnWidth(CHARQUESTINFO_SLOT_LEVEL, 100);
+    tmpQuest->setColumnWidth(CHARQUESTINFO_SLOT_STATUS, 150);
+    tmpQuest->resize(Wt::WLength::Auto, CHARACTER_TABLE_HEIGHT);
 
     return tmpQuest;
 }
@@ -391,18 +596,20 @@ WTable * CharacterInfoPage::CreateCharacterQuestInfo()
  *
  ***********************************************/
 
-WTable * CharacterInfoPage::CreateCharacterSpellInfo()
+Wt::WTableView * CharacterInfoPage::CreateCharacterSpellInfo()
 {
-    LoadSpells();
-
-    WTable * tmpSpell = new WTable();
+    Wt::WTableView * tmpSpell = new Wt::WTableView();
 
-    tmpSpell->setHeaderCount(1);
+    spellModel = new CharacterSpellsModel(tmpSpell);
 
-    tmpSpell->elementAt(0, CHARSPELLINFO_SLOT_ID)->addWidget(new WText(Wt::WString::tr(TXT_SPELL_ID)));
-    tmpSpell->elementAt(0, CHARSPELLINFO_SLOT_NAME)->addWidget(new WText(Wt::WString::tr(TXT_SPELL_NAME)));
-    tmpSpell->elementAt(0, CHARSPELLINFO_SLOT_ACTIVE)->addWidget(new WText(Wt::WString::tr(TXT_SPELL_ACTIVE)));
-    tmpSpell->elementAt(0, CHARSPELLINFO_SLOT_DISABLED)->addWidget(new WText(Wt::WString::tr(TXT_SPELL_DISABLED)));
+    tmpSpell->setModel(spellModel);
+    tmpSpell->setAlternatingRowColors(true);
+    tmpSpell->setSortingEnabled(CHARSPELLINFO_SLOT_NAME, false);
+    tmpSpell->setColumnWidth(CHARSPELLINFO_SLOT_ID, 80);
+    tmpSpell->setColumnWidth(CHARSPELLINFO_SLOT_NAME, 300);
+    tmpSpell->setColumnWidth(CHARSPELLINFO_SLOT_ACTIVE, 80);
+    tmpSpell->setColumnWidth(CHARSPELLINFO_SLOT_DISABLED, 80);
+    tmpSpell->resize(Wt::WLength::Auto, CHARACTER_TABLE_HEIGHT);
 
     return tmpSpell;
 }
@@ -414,15 +621,19 @@ WTable * CharacterInfoPage::CreateCharacterSpellInfo()
  *
  ***********************************************/
 
-WTable * CharacterInfoPage::CreateCharacterInventoryInfo()
+Wt::WTableView * CharacterInfoPage::CreateCharacterInventoryInfo()
 {
-    WTable * tmpInv = new WTable();
+    Wt::WTableView * tmpInv = new Wt::WTableView();
 
-    tmpInv->setHeaderCount(1);
+    inventoryModel = new CharacterInventoryModel(tmpInv);
 
-    tmpInv->elementAt(0, CHARINVINFO_SLOT_ID)->addWidget(new WText(Wt::WString::tr(TXT_ITEM_ID)));
-    tmpInv->elementAt(0, CHARINVINFO_SLOT_NAME)->addWidget(new WText(Wt::WString::tr(TXT_ITEM_NAME)));
-    tmpInv->elementAt(0, CHARINVINFO_SLOT_STACK)->addWidget(new WText(Wt::WString::tr(TXT_ITEM_COUNT)));
+    tmpInv->setModel(inventoryModel);
+    tmpInv->setAlternatingRowColors(true);
+    tmpInv->setSortingEnabled(CHARINVINFO_SLOT_STACK, false);
+    tmpInv->setColumnWidth(CHARINVINFO_SLOT_ID, 80);
+    tmpInv->setColumnWidth(CHARINVINFO_SLOT_NAME, 300);
+    tmpInv->setColumnWidth(CHARINVINFO_SLOT_STACK, 80);
+    tmpInv->resize(Wt::WLength::Auto, CHARACTER_TABLE_HEIGHT);
 
     return tmpInv;
 }
@@ -503,25 +714,25 @@ Wt::WContainerWidget * CharacterInfoPage::CreateCharacterMailInfo()
  *
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterBasicInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterBasicInfo(uint64 guid)
 {
     Database db;
     if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
     {
         charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
+        return false;
     }
 
-    switch (db.ExecutePQuery("SELECT level, race, class, name, online, totaltime, leveltime, resettalents_cost, FROM_UNIXTIME(resettalents_time), DATEDIFF(now(), FROM_UNIXTIME(resettalents_time)), date "
-                             "FROM characters LEFT OUTER JOIN deleted_chars ON characters.guid = deleted_chars.char_guid "
-                             "WHERE guid = '%u'", guid))
+    switch (db.ExecuteStatement("SELECT level, race, class, name, online, totaltime, leveltime, resettalents_cost, FROM_UNIXTIME(resettalents_time), DATEDIFF(now(), FROM_UNIXTIME(resettalents_time)), date "
+                                "FROM characters LEFT OUTER JOIN deleted_chars ON characters.guid = deleted_chars.char_guid "
+                                "WHERE guid = ?", DatabaseParams().AddUInt64(guid)))
     {
         case DB_RESULT_ERROR:
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
+            return false;
         case DB_RESULT_EMPTY:
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_EMPTY));
-            return;
+            return false;
         default:
         {
             db.Disconnect();
@@ -576,6 +787,8 @@ void CharacterInfoPage::UpdateCharacterBasicInfo(uint64 guid)
             break;
         }
     }
+
+    return true;
 }
 
 /********************************************//**
@@ -585,63 +798,22 @@ void CharacterInfoPage::UpdateCharacterBasicInfo(uint64 guid)
  *
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterQuestInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterQuestInfo(uint64 guid)
 {
-    Database db;
-    if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
-    {
-        charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
-    }
-
-    // TODO: fix world join
-    switch (db.ExecutePQuery("SELECT cq.quest, qt.Name, qt.QuestLevel, cq.status, cq.rewarded, qt.Type, qt.MinLevel "
-                            "FROM character_queststatus AS cq JOIN %s.quest_template AS qt ON cq.quest = qt.entry "
-                            "WHERE guid = %u", "world", guid))
+    // only rows count is read here, pages are read when view shows them
+    switch (questModel->Load(session->currentRealm, guid))
     {
         case DB_RESULT_ERROR:
-        {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
-        }
+            return false;
         case DB_RESULT_EMPTY:
-        {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_EMPTY));
-            return;
-        }
+            break;
         default:
-        {
-            db.Disconnect();
-            std::list<DatabaseRow*> rows = db.GetRows();
-
-            Misc::Console(DEBUG_CODE, "Quest count: %lu | %lu", rows.size(), db.GetRowsCount());
-
-            WTable * tmpTable = (WTable*)tabs->widget(CHAR_TAB_QUEST);
-
-            int i = tmpTable->rowCount() - 1;
-
-            for (; i > 0; --i)
-                tmpTable->deleteRow(i);
-
-            i = 1;
-
-            DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
-            {
-                tmpRow = *itr;
-
-                if (tmpRow->fields[5].GetInt() == QUEST_TYPE_DAILY)
-                    continue;
-
-                tmpTable->elementAt(i, 0)->addWidget(new WText(Wt::WString::tr(TXT_QUEST_LINK_NAME_FMT).arg(tmpRow->fields[0].GetInt()).arg(tmpRow->fields[1].GetCString())));
-                tmpTable->elementAt(i, 0)->setToolTip(Wt::WString::tr(TXT_QUEST_TOOLTIP_FMT).arg(tmpRow->fields[0].GetInt()).arg(tmpRow->fields[6].GetInt()), Wt::XHTMLText);
-                tmpTable->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[2].GetWString()));
-                tmpTable->elementAt(i, 2)->addWidget(new WText(Misc::Character::GetQuestStatus(tmpRow->fields[3].GetInt(), tmpRow->fields[4].GetBool())));
-            }
-
             break;
-        }
     }
+
+    return true;
 }
 
 /********************************************//**
@@ -651,57 +823,25 @@ void CharacterInfoPage::UpdateCharacterQuestInfo(uint64 guid)
  *
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterSpellInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterSpellInfo(uint64 guid)
 {
-    Database db;
-    if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
-    {
-        charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
-    }
+    // dictionary is immutable, model keeps one reference for all rows
+    spellModel->SetSpells(sSpellDictionary.GetSpells());
 
-    switch (db.ExecutePQuery("SELECT spell, active, disabled "
-                             "FROM character_spell "
-                             "WHERE guid = '%u'", guid))
+    // only rows count is read here, pages are read when view shows them
+    switch (spellModel->Load(session->currentRealm, guid))
     {
         case DB_RESULT_ERROR:
-        {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
-        }
+            return false;
         case DB_RESULT_EMPTY:
-        {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_EMPTY));
-            return;
-        }
+            break;
         default:
-        {
-            db.Disconnect();
-            std::list<DatabaseRow*> rows = db.GetRows();
-
-            WTable * tmpTable = (WTable*)tabs->widget(CHAR_TAB_SPELL);
-
-            int i = tmpTable->rowCount() - 1;
-
-            for (; i > 0; --i)
-                tmpTable->deleteRow(i);
-
-            i = 1;
-
-            DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
-            {
-                tmpRow = *itr;
-
-                tmpTable->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
-                tmpTable->elementAt(i, 1)->addWidget(new WText(spells[tmpRow->fields[0].GetUInt32()].name));
-                tmpTable->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(tmpRow->fields[1].GetBool() ? TXT_GEN_YES : TXT_GEN_NO)));
-                tmpTable->elementAt(i, 3)->addWidget(new WText(Wt::WString::tr(tmpRow->fields[2].GetBool() ? TXT_GEN_YES : TXT_GEN_NO)));
-            }
-
             break;
-        }
     }
+
+    return true;
 }
 
 /********************************************//**
@@ -711,179 +851,195 @@ void CharacterInfoPage::UpdateCharacterSpellInfo(uint64 guid)
  *
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterInventoryInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterInventoryInfo(uint64 guid)
 {
-    Database db;
-    if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
-    {
-        charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
-    }
-
-    // TODO: fix world join
-    switch (db.ExecutePQuery("SELECT ci.item_template, it.name, CAST(SUBSTRING_INDEX(SUBSTRING_INDEX(`data`, ' ', 15), ' ', -1) AS UNSIGNED) AS count "
-                            "FROM character_inventory AS ci JOIN item_instance AS ii ON ci.item = ii.guid JOIN %s.item_template AS it ON ci.item_template = it.entry "
-                            "WHERE ci.guid = %u", "world", guid))
+    // only rows count is read here, pages are read when view shows them
+    switch (inventoryModel->Load(session->currentRealm, guid))
     {
         case DB_RESULT_ERROR:
-        {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
-        }
-        case DB_RESULT_EMPTY:
-        {
-            return;
-        }
+            return false;
         default:
-        {
-            db.Disconnect();
-            std::list<DatabaseRow*> rows = db.GetRows();
-
-            WTable * tmpTable = (WTable*)tabs->widget(CHAR_TAB_INVENTORY);
-
-            int i = tmpTable->rowCount() - 1;
-
-            for (; i > 0; --i)
-                tmpTable->deleteRow(i);
-
-            i = 1;
-
-            DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
-            {
-                tmpRow = *itr;
-
-                tmpTable->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
-                tmpTable->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
-                tmpTable->elementAt(i, 2)->addWidget(new WText(tmpRow->fields[2].GetWString()));
-            }
-
             break;
-        }
     }
+
+    return true;
 }
 
 /********************************************//**
  * \brief Update Character Friend Informations widgets.
  *
- * Only informations update. There is no need to delete old and create new widgets.
+ * Rows are matched with friends by guid, so only rows of added or removed
+ * friends are inserted/deleted and only changed texts are updated.
  *
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterFriendInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterFriendInfo(uint64 guid)
 {
     Database db;
     if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
     {
         charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
+        return false;
     }
 
-    switch (db.ExecutePQuery("SELECT ch.name, note, flags, ch.online "
-                            "FROM character_social AS cs JOIN characters AS ch ON cs.friend = ch.guid "
-                            "WHERE cs.guid = '%u'", guid))
+    int count = db.ExecuteStatement("SELECT cs.friend, ch.name, note, ch.online "
+                                    "FROM character_social AS cs JOIN characters AS ch ON cs.friend = ch.guid "
+                                    "WHERE cs.guid = ? AND (flags & ?) <> 0 ORDER BY ch.name", DatabaseParams().AddUInt64(guid).AddUInt32(SOCIAL_FLAG_FRIEND));
+
+    if (count == DB_RESULT_ERROR)
     {
-        case DB_RESULT_ERROR:
-        {
-            charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
-        }
-        case DB_RESULT_EMPTY:
-            return;
-        default:
-        {
-            db.Disconnect();
-            std::list<DatabaseRow*> rows = db.GetRows();
+        charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+        return false;
+    }
+
+    db.Disconnect();
 
-            WTable * tmpTable = (WTable*)tabs->widget(CHAR_TAB_FRIENDS);
+    WTable * tmpTable = (WTable*)tabs->widget(CHAR_TAB_FRIENDS);
 
-            int i = tmpTable->rowCount() - 1;
+    std::set<uint64> guids;
+    for (int i = 0; i < count; ++i)
+        guids.insert(db.GetRow(i)->fields[0].GetUInt64());
 
-            for (; i > 0; --i)
-                tmpTable->deleteRow(i);
+    // rows of removed friends, row 0 is header
+    for (int i = int(friendGuids.size()) - 1; i >= 0; --i)
+    {
+        if (guids.find(friendGuids[i]) == guids.end())
+        {
+            tmpTable->deleteRow(i + 1);
+            friendGuids.erase(friendGuids.begin() + i);
+        }
+    }
 
-            i = 1;
+    const DatabaseRow * tmpRow;
+    for (int i = 0; i < count; ++i)
+    {
+        tmpRow = db.GetRow(i);
+        uint64 friendGuid = tmpRow->fields[0].GetUInt64();
 
-            DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+        if (i >= int(friendGuids.size()) || friendGuids[i] != friendGuid)
+        {
+            // friend moved (renamed), so its old row is removed
+            std::vector<uint64>::iterator itr = std::find(friendGuids.begin() + i, friendGuids.end(), friendGuid);
+            if (itr != friendGuids.end())
             {
-                tmpRow = *itr;
-
-                if (tmpRow->fields[2].GetUInt32() & SOCIAL_FLAG_FRIEND)
-                {
-                    tmpTable->elementAt(i, 0)->addWidget(new WText(tmpRow->fields[0].GetWString()));
-                    tmpTable->elementAt(i, 1)->addWidget(new WText(tmpRow->fields[1].GetWString()));
-                    tmpTable->elementAt(i, 2)->addWidget(new WText(Wt::WString::tr(tmpRow->fields[3].GetBool() ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE)));
-                    ++i;
-                }
+                tmpTable->deleteRow(itr - friendGuids.begin() + 1);
+                friendGuids.erase(itr);
             }
 
-            break;
+            tmpTable->insertRow(i + 1);
+            friendGuids.insert(friendGuids.begin() + i, friendGuid);
         }
+
+        SetFriendCell(tmpTable, i + 1, CHARFRIENDINFO_SLOT_NAME, tmpRow->fields[1].GetWString());
+        SetFriendCell(tmpTable, i + 1, CHARFRIENDINFO_SLOT_NOTE, tmpRow->fields[2].GetWString());
+        SetFriendCell(tmpTable, i + 1, CHARFRIENDINFO_SLOT_ONLINE, Wt::WString::tr(tmpRow->fields[3].GetBool() ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE));
+    }
+
+    return true;
+}
+
+/********************************************//**
+ * \brief Sets text in friends table cell.
+ *
+ * Text widget is created only for new row and text is changed only
+ * when it differs, so unchanged rows don't generate any update.
+ *
+ ***********************************************/
+
+void CharacterInfoPage::SetFriendCell(WTable * table, int row, int column, const Wt::WString & text)
+{
+    WTableCell * cell = table->elementAt(row, column);
+
+    if (!cell->count())
+    {
+        cell->addWidget(new WText(text));
+        return;
     }
+
+    WText * tmpText = (WText*)cell->widget(0);
+
+    if (tmpText->text() != text)
+        tmpText->setText(text);
 }
 
 /********************************************//**
  * \brief Update Character Mails widgets.
  ***********************************************/
 
-void CharacterInfoPage::UpdateCharacterMailInfo(uint64 guid)
+bool CharacterInfoPage::UpdateCharacterMailInfo(uint64 guid)
 {
+    // mails of previously shown character are removed also when there is nothing to show
+    ClearMails();
+
     Database db;
     if (!db.Connect(DB_REALM_DATA(session->currentRealm)))
     {
         charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_CANT_CONNECT));
-        return;
+        return false;
     }
 
-    // get all delivered mails
-    switch (db.ExecutePQuery("SELECT mail.id, ch.name, mail.messageType, mail.stationery, mail.subject, FROM_UNIXTIME(mail.deliver_time), FROM_UNIXTIME(mail.expire_time), it.text, mail.money, mail.cod, mail.checked "
-                            "FROM mail LEFT OUTER JOIN item_text as it on mail.itemTextId = it.id JOIN characters AS ch ON mail.sender = ch.guid "
-                            "WHERE mail.receiver = '%u' AND mail.deliver_time < UNIX_TIMESTAMP()", guid))
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    // get headers of all delivered mails, bodies are read on preview
+    switch (db.ExecuteStatement("SELECT mail.id, ch.name, mail.messageType, mail.stationery, mail.subject, FROM_UNIXTIME(mail.deliver_time), FROM_UNIXTIME(mail.expire_time), mail.itemTextId, mail.money, mail.cod, mail.checked "
+                                "FROM mail JOIN characters AS ch ON mail.sender = ch.guid "
+                                "WHERE mail.receiver = ? AND mail.deliver_time < UNIX_TIMESTAMP()", DatabaseParams().AddUInt64(guid)))
     {
         case DB_RESULT_ERROR:
         {
             charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
-            return;
+            return false;
         }
         case DB_RESULT_EMPTY:
-            return;
+            return true;
         default:
         {
-            std::list<DatabaseRow*> mailItems;
-            std::list<DatabaseRow*> mails = db.GetRows();
+            const std::vector<DatabaseRow> & mails = db.GetRows();
             db.Disconnect();
 
+            // prepare character mail informations
+            std::unordered_map<uint64, MailInfo*> idToMail;
+            characterMails.reserve(mails.size());
+
+            for (std::vector<DatabaseRow>::const_iterator itr = mails.begin(); itr != mails.end(); ++itr)
+            {
+                characterMails.push_back(MailInfo(&*itr));
+                idToMail[characterMails.back().id] = &characterMails.back();
+            }
+
+            uint32 headersTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+            startTime = std::chrono::steady_clock::now();
+
+            // mails without items are still listed, but tab is loaded again later
+            bool itemsLoaded = false;
+
             Database db2;
             if (db2.Connect(DB_REALM_DATA(session->currentRealm)))
             {
                 // get all items attached to mails
-                if (db2.ExecutePQuery("SELECT mail_id, item_template, name, CAST(SUBSTRING_INDEX(SUBSTRING_INDEX(`data`, ' ', 15), ' ', -1) AS UNSIGNED) AS count, item_guid "
-                                        "FROM mail_items AS mi JOIN item_instance AS ii ON mi.item_guid = ii.guid LEFT OUTER JOIN world.item_template AS it ON mi.item_template = it.entry "
-                                        "WHERE receiver = '%u'", guid) == DB_RESULT_ERROR)
+                if (db2.ExecuteStatement("SELECT mail_id, item_template, name, `data`, item_guid "
+                                         "FROM mail_items AS mi JOIN item_instance AS ii ON mi.item_guid = ii.guid LEFT OUTER JOIN world.item_template AS it ON mi.item_template = it.entry "
+                                         "WHERE receiver = ?", DatabaseParams().AddUInt64(guid)) == DB_RESULT_ERROR)
                     charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
+                else
+                    itemsLoaded = true;
 
                 db2.Disconnect();
-                mailItems = db2.GetRows();
-            }
-
-            // clear mail table if there is anything in it
-            ClearMails();
-
-            DatabaseRow * tmpRow;
 
-            // prepare character mail informations
-            for (std::list<DatabaseRow*>::const_iterator itr = mails.begin(); itr != mails.end(); ++itr)
-            {
-                // copy mail data
-                MailInfo info(*itr);
-                // and load items attached to current mail
-                info.LoadItems(mailItems);
-
-                // store prepared mail
-                characterMails.push_back(info);
+                // items are added to their mails in one pass
+                const std::vector<DatabaseRow> & items = db2.GetRows();
+                for (std::vector<DatabaseRow>::const_iterator itr = items.begin(); itr != items.end(); ++itr)
+                {
+                    std::unordered_map<uint64, MailInfo*>::const_iterator mail = idToMail.find(itr->fields[0].GetUInt64());
+                    if (mail != idToMail.end())
+                        mail->second->AddItem(&*itr);
+                }
             }
 
+            Misc::Console(DEBUG_CODE, "CharacterInfoPage::UpdateCharacterMailInfo(): %u mails loaded in %u ms, items in %u ms\n", uint32(characterMails.size()), headersTime,
+                          uint32(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()));
+
             // fill character mail list
             int i = 1;
             for (std::vector<MailInfo>::const_iterator itr = characterMails.begin(); itr != characterMails.end(); ++itr, ++i)
@@ -901,9 +1057,11 @@ void CharacterInfoPage::UpdateCharacterMailInfo(uint64 guid)
                     BindPreviewMail(mailList->elementAt(i, j)->clicked(), i-1); // i-1 'cause we have 1 header row
             }
 
-            break;
+            return itemsLoaded;
         }
     }
+
+    return true;
 }
 
 /********************************************//**
@@ -917,6 +1075,9 @@ void CharacterInfoPage::PreviewMail(int mailIdx)
     if (mailIdx >= characterMails.size())
         return;
 
+    // body isn't read with mails list
+    characterMails[mailIdx].LoadBody(session->currentRealm);
+
     mailPreviewFrom->setText(characterMails[mailIdx].GetFrom());
     mailPreviewExpire->setText(characterMails[mailIdx].GetExpireTime());
     mailPreviewSubject->setText(characterMails[mailIdx].GetSubject());
@@ -938,6 +1099,17 @@ void CharacterInfoPage::ClearPage()
 
     needCreation = true;
     indexToCharInfo.clear();
+
+    // tabs are recreated, so nothing is loaded
+    currentGuid = 0;
+    infoTab = -1;
+    questModel = NULL;
+    spellModel = NULL;
+    inventoryModel = NULL;
+    friendGuids.clear();
+
+    for (int i = 0; i < CHAR_TAB_COUNT; ++i)
+        tabStates[i] = CharTabState();
 }
 
 /********************************************//**
@@ -1084,7 +1256,7 @@ void CharacterInfoPage::RestoreCharacter()
                     restoreCharacter->hide();
                     charBasicInfo->rowAt(CHARBASICINFO_SLOT_DELETION_TIME)->hide();
 
-                    Misc::Account::AddActivity(tmpCharInfo.account, session->sessionIp.toUTF8().c_str(), TXT_ACT_CHARACTER_RESTORE, escapedName.c_str());
+                    Misc::Account::AddActivity(tmpCharInfo.account, session->sessionIp.toUTF8(), TXT_ACT_CHARACTER_RESTORE, tmpCharInfo.name.toUTF8());
                 }
                 else
                     charPageInfo->setText(Wt::WString::tr(TXT_ERROR_DB_QUERY_ERROR));
@@ -1117,30 +1289,6 @@ void CharacterInfoPage::RebuildCharList()
         charList->setCurrentIndex(currIndex);
 }
 
-void CharacterInfoPage::LoadSpells()
-{
-    if (spellsLoaded)
-        return;
-
-    Database db;
-    if (!db.Connect(DB_PANEL_DATA))
-        return;
-
-    db.ExecuteQuery("SELECT entry, name FROM spells");
-
-    std::list<DatabaseRow*> rows = db.GetRows();
-
-    uint32 tmpEntry;
-    for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
-    {
-        tmpEntry = (*itr)->fields[0].GetUInt32();
-        spells[tmpEntry].entry = tmpEntry;
-        spells[tmpEntry].name = (*itr)->fields[1].GetWString();
-    }
-
-    spellsLoaded = true;
-}
-
 void CharacterInfoPage::BindPreviewMail(Wt::EventSignal<Wt::WMouseEvent>& signal, int mailIdx)
 {
     signal.connect(boost::bind(&CharacterInfoPage::PreviewMail, this, mailIdx));
@@ -41,6 +41,13 @@
 #include <Wt/WContainerWidget>
 
 #include "../defines.h"
+#include "../pagedQueryModel.h"
+#include "../spellDictionary.h"
+
+namespace Wt
+{
+    class WTableView;
+}
 
 /********************************************//**
  * \brief Slots for Basic Character Informations
@@ -159,6 +166,18 @@ enum CharacterTabsSlots
     CHAR_TAB_COUNT
 };
 
+/********************************************//**
+ * \brief Informations about data loaded in character tab.
+ ***********************************************/
+
+struct CharTabState
+{
+    CharTabState() : guid(0), loadTime(0) {}
+
+    uint64 guid;                            /**< Character which data is shown in tab. */
+    std::time_t loadTime;                   /**< Time when data was loaded. */
+};
+
 /********************************************//**
  * \brief Structure to store some character informations.
  *
@@ -221,7 +240,8 @@ struct MailInfo
 
     ~MailInfo() {}
 
-    void LoadItems(std::list<DatabaseRow*> & mailItems);
+    void AddItem(const DatabaseRow * row);              /// adds item from mail items query row
+    void LoadBody(int realm);                           /// reads mail text from db (only once)
 
     Wt::WString GetFrom() const;
 
@@ -242,6 +262,8 @@ struct MailInfo
     uint32 money;
     uint32 cod;
     uint64 checkMask;
+    uint32 textId;                                      /// item_text id, body is read on first preview
+    bool textLoaded;
 
     Wt::WString from;
     Wt::WString subject;
@@ -252,6 +274,56 @@ struct MailInfo
     std::list<Item> items;
 };
 
+/********************************************//**
+ * \brief Character quests read page by page.
+ ***********************************************/
+
+class CharacterQuestsModel : public PagedQueryModel
+{
+public:
+    CharacterQuestsModel(Wt::WObject * parent = 0);
+
+    Wt::WFlags<Wt::ItemFlag> flags(const Wt::WModelIndex & index) const;
+
+protected:
+    boost::any GetData(const DatabaseRow & row, int column, int role) const;
+};
+
+/********************************************//**
+ * \brief Character spells read page by page.
+ *
+ * Names are taken from spell dictionary,
+ * so spells can't be sorted by name.
+ *
+ ***********************************************/
+
+class CharacterSpellsModel : public PagedQueryModel
+{
+public:
+    CharacterSpellsModel(Wt::WObject * parent = 0);
+
+    void SetSpells(SpellTablePtr spellTable) { spells = spellTable; }
+
+protected:
+    boost::any GetData(const DatabaseRow & row, int column, int role) const;
+
+private:
+    SpellTablePtr spells;
+};
+
+/********************************************//**
+ * \brief Character inventory read page by page.
+ ***********************************************/
+
+class CharacterInventoryModel : public PagedQueryModel
+{
+public:
+    CharacterInventoryModel(Wt::WObject * parent = 0);
+
+protected:
+    boost::any GetData(const DatabaseRow & row, int column, int role) const;
+};
+
 /********************************************//**
  * \brief A class to represents Character Informations page
  *
@@ -270,9 +342,6 @@ public:
 
     void refresh();
 
-    static std::map<uint32, SpellInfo> spells;
-    static bool spellsLoaded;
-
 private:
     /// panel session informations
     SessionInfo * session;
@@ -288,8 +357,14 @@ private:
     WPushButton * restoreCharacter;
     /// combo box index to character guid map
     std::map<int, CharInfo> indexToCharInfo;
-    /// last character info update time
-    std::time_t lastUpdateTime;
+    /// currently selected character
+    uint64 currentGuid;
+    /// data loaded in each tab, tab is loaded only when it's visible
+    CharTabState tabStates[CHAR_TAB_COUNT];
+    /// locale for which tabs were loaded
+    std::string namesLocale;
+    /// tab which load set current charPageInfo message (-1 if none)
+    int infoTab;
     /// table with character mail list
     Wt::WTable * mailList;
     /// container with mail preview
@@ -309,27 +384,36 @@ private:
     bool IsDeletedCharacter(const uint64 & guid);
     bool IsDeletedCharacter(const CharInfo & charInfo) { return charInfo.deleted; }
 
+    /// models of paged tabs (owned by views)
+    CharacterQuestsModel * questModel;
+    CharacterSpellsModel * spellModel;
+    CharacterInventoryModel * inventoryModel;
+
     void UpdateInformations(uint64 guid, bool force = false);
+    void UpdateTab(int tab, bool force = false);
+    void TabChanged(int tab);
 
     Wt::WTable * charBasicInfo;
     Wt::WContainerWidget * CreateCharacterBasicInfo();
-    void UpdateCharacterBasicInfo(uint64 guid);
+    bool UpdateCharacterBasicInfo(uint64 guid);
 
-    Wt::WTable * CreateCharacterQuestInfo();
-    void UpdateCharacterQuestInfo(uint64 guid);
+    Wt::WTableView * CreateCharacterQuestInfo();
+    bool UpdateCharacterQuestInfo(uint64 guid);
 
-    WTable * CreateCharacterSpellInfo();
-    void UpdateCharacterSpellInfo(uint64 guid);
+    Wt::WTableView * CreateCharacterSpellInfo();
+    bool UpdateCharacterSpellInfo(uint64 guid);
 
-    WTable * CreateCharacterInventoryInfo();
-    void UpdateCharacterInventoryInfo(uint64 guid);
+    Wt::WTableView * CreateCharacterInventoryInfo();
+    bool UpdateCharacterInventoryInfo(uint64 guid);
 
+    std::vector<uint64> friendGuids;                    /// friend guid for each friends table row (without header)
     WTable * CreateCharacterFriendInfo();
-    void UpdateCharacterFriendInfo(uint64 guid);
+    bool UpdateCharacterFriendInfo(uint64 guid);
+    void SetFriendCell(WTable * table, int row, int column, const Wt::WString & text);
     void ClearFriendsTable();
 
     Wt::WContainerWidget * CreateCharacterMailInfo();
-    void UpdateCharacterMailInfo(uint64 guid);
+    bool UpdateCharacterMailInfo(uint64 guid);
     void ClearMails();
 
     void ClearPage();
@@ -340,8 +424,6 @@ private:
 
     void RestoreCharacter();
 
-    void LoadSpells();
-
     void PreviewMail(int mailIdx);
     void BindPreviewMail(Wt::EventSignal<Wt::WMouseEvent>& signal, int mailIdx);
 };
@@ -245,15 +245,8 @@ void RegisterPage::Register()
 
     regInfo->setText(Wt::WString::tr(TXT_REG_COMPLETE));
 
-    uint32 accId;
-
-    if (db.ExecutePQuery("SELECT account_id FROM account WHERE username = '%s'", login.toUTF8().c_str()) > DB_RESULT_EMPTY)
-        accId = db.GetRow()->fields[0].GetUInt32();
-    else
-        return;
-
-    if (db.Connect(DB_PANEL_DATA))
-        db.ExecutePQuery("INSERT INTO Activity VALUES ('%u', NOW(), '%s', '%s', '')", accId, session->sessionIp.toUTF8().c_str(), TXT_ACT_REGISTRATION_COMPLETE);
+    // account id will be resolved by activity log
+    Misc::Account::AddActivity(login.toUTF8(), session->sessionIp.toUTF8(), TXT_ACT_REGISTRATION_COMPLETE, "");
 }
 
 /********************************************//**
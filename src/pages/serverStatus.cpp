@@ -29,19 +29,20 @@
 
 #include "serverStatus.h"
 
-#include <iostream>
-#include <sstream>
-
-#include <Wt/Http/Client>
-#include <Wt/Http/Message>
 #include <Wt/WBreak>
+#include <Wt/WPainter>
+#include <Wt/WPainterPath>
+#include <Wt/WPen>
 #include <Wt/WTable>
 #include <Wt/WText>
-#include <Wt/WTimer>
 
 #include "../config.h"
 #include "../misc.h"
 
+#define SPARKLINE_WIDTH     288
+#define SPARKLINE_HEIGHT    40
+#define SPARKLINE_COLOR     0, 102, 204
+
 /********************************************//**
  * \brief Creates new ServerStatusPage object.
  *
@@ -54,13 +55,17 @@ ServerStatusPage::ServerStatusPage(Wt::WContainerWidget * parent)
 : Wt::WContainerWidget(parent)
 {
     Misc::Console(DEBUG_CODE, "%s\n", __FUNCTION__);
-    timer = new Wt::WTimer();
-    timer->setInterval(60000);
-    timer->timeout().connect(this, &ServerStatusPage::RunUpdateStatus);
 
-    realms = new Wt::WTable*[sConfig.GetConfig(CONFIG_REALMS_COUNT)];
-    texts = new Wt::WText**[sConfig.GetConfig(CONFIG_REALMS_COUNT)];
-    clients = new Wt::Http::Client*[sConfig.GetConfig(CONFIG_REALMS_COUNT)];
+    // realms count can change after config reload, tables are created only once
+    realmsCount = sConfig.GetConfig(CONFIG_REALMS_COUNT);
+
+    realms = new Wt::WTable*[realmsCount];
+    texts = new Wt::WText**[realmsCount];
+    sparklines = new StatusSparkline**[realmsCount];
+    shown = new RealmStatusPtr[realmsCount];
+
+    // menu creates all pages at once, so poller subscription is made when page is shown (refresh)
+    subscription = 0;
 
     setStyleClass("page statuswidget");
 
@@ -69,25 +74,34 @@ ServerStatusPage::ServerStatusPage(Wt::WContainerWidget * parent)
 
 ServerStatusPage::~ServerStatusPage()
 {
+    if (subscription)
+        sRealmStatusPoller.Unsubscribe(subscription);
+
     // clears and deletes widgets
     clear();
 
     // null tables and delete them
-    for (int i = 0; i < sConfig.GetConfig(CONFIG_REALMS_COUNT); ++i)
+    for (int i = 0; i < realmsCount; ++i)
     {
         realms[i] = nullptr;
-        clients[i] = nullptr;
 
         for (int j = SERVER_STATUS_TEXT_REALM; j < SERVER_STATUS_TEXT_SLOT_COUNT; ++j)
             texts[i][j] = nullptr;
 
         delete [] texts[i];
         texts[i] = nullptr;
+
+        for (int j = STATUS_HISTORY_DAY; j < STATUS_HISTORY_TIER_COUNT; ++j)
+            sparklines[i][j] = nullptr;
+
+        delete [] sparklines[i];
+        sparklines[i] = nullptr;
     }
 
     delete [] realms;
     delete [] texts;
-    delete [] clients;
+    delete [] sparklines;
+    delete [] shown;
 }
 
 /********************************************//**
@@ -103,6 +117,13 @@ void ServerStatusPage::refresh()
     if (isHidden() || isDisabled())
         return;
 
+    // poller pushes changes to session only while page is shown, there is no need for own timer
+    if (!subscription)
+        subscription = sRealmStatusPoller.Subscribe(boost::bind(&ServerStatusPage::RunUpdateStatus, this));
+
+    // changes made while page was hidden weren't pushed
+    RunUpdateStatus();
+
     Wt::WContainerWidget::refresh();
 }
 
@@ -122,8 +143,6 @@ void ServerStatusPage::CreateStatusPage()
     for (int i = 0; i < 4; ++i)
         addWidget(new Wt::WBreak());
 
-    int realmsCount = sConfig.GetConfig(CONFIG_REALMS_COUNT);
-
     for (int i = 0; i < realmsCount; ++i)
     {
         realms[i] = new Wt::WTable();
@@ -153,17 +172,23 @@ void ServerStatusPage::CreateStatusPage()
 
         realms[i]->elementAt(SERVER_STATUS_TEXT_INFO, 0)->setColumnSpan(2);
 
+        // history charts are placed below realm info
+        sparklines[i] = new StatusSparkline*[STATUS_HISTORY_TIER_COUNT];
+
+        for (int j = STATUS_HISTORY_DAY; j < STATUS_HISTORY_TIER_COUNT; ++j)
+        {
+            sparklines[i][j] = new StatusSparkline();
+
+            realms[i]->elementAt(SERVER_STATUS_TEXT_SLOT_COUNT + j, 0)->addWidget(new Wt::WText(Wt::WString::tr(j == STATUS_HISTORY_DAY ? TXT_STATUS_HISTORY_DAY : TXT_STATUS_HISTORY_MONTH)));
+            realms[i]->elementAt(SERVER_STATUS_TEXT_SLOT_COUNT + j, 1)->addWidget(sparklines[i][j]);
+        }
+
         addWidget(realms[i]);
         addWidget(new WBreak());
         addWidget(new WBreak());
-
-        clients[i] = new Wt::Http::Client(this);
-        clients[i]->setTimeout(15);
-        clients[i]->done().connect(boost::bind(&ServerStatusPage::UpdateStatus, this, _1, _2, i));
     }
 
     RunUpdateStatus();
-    timer->start();
 
     Misc::Console(DEBUG_CODE, "%s End\n", __FUNCTION__);
 }
@@ -171,7 +196,9 @@ void ServerStatusPage::CreateStatusPage()
 /********************************************//**
  * \brief Updates server status
  *
- * This function parse and updates server status in content.
+ * This function takes last status snapshots (fetched once for all sessions)
+ * and updates server status in content. Called when poller pushes changed
+ * status and when page is shown.
  *
  ***********************************************/
 
@@ -180,44 +207,61 @@ void ServerStatusPage::RunUpdateStatus()
     Misc::Console(DEBUG_CODE, "Entering %s\n", __FUNCTION__);
 
     if (isHidden() || isDisabled())
-        return;
+    {
+        // page was hidden - next changes aren't pushed until it's shown again
+        if (subscription)
+        {
+            sRealmStatusPoller.Unsubscribe(subscription);
+            subscription = 0;
+        }
 
-    int realmsCount = sConfig.GetConfig(CONFIG_REALMS_COUNT);
+        return;
+    }
 
     for (int i = 0; i < realmsCount; ++i)
-        clients[i]->get(sConfig.GetRealmInformations(i).statusUrl);
+    {
+        for (int j = STATUS_HISTORY_DAY; j < STATUS_HISTORY_TIER_COUNT; ++j)
+        {
+            StatusHistoryPointsPtr points = sRealmStatusPoller.GetHistoryPoints(i, StatusHistoryTier(j));
+
+            if (points != sparklines[i][j]->GetPoints())
+                sparklines[i][j]->SetPoints(points);
+        }
+
+        RealmStatusPtr status = sRealmStatusPoller.GetStatus(i);
+
+        // same snapshot is already shown
+        if (status == shown[i])
+            continue;
+
+        UpdateStatus(*status, shown[i].get(), i);
+        shown[i] = status;
+    }
 
     Misc::Console(DEBUG_CODE, "%s End\n", __FUNCTION__);
 }
 
-void ServerStatusPage::UpdateStatus(boost::system::error_code err, const Wt::Http::Message& response, int realmId)
+/********************************************//**
+ * \brief Updates texts of one realm
+ *
+ * \param status    status to show
+ * \param previous  status shown before (NULL when nothing was shown)
+ * \param realmId   realm index
+ *
+ * Only texts with changed values are set so unchanged ones aren't sent to client again.
+ *
+ ***********************************************/
+
+void ServerStatusPage::UpdateStatus(const RealmStatus & status, const RealmStatus * previous, int realmId)
 {
     Misc::Console(DEBUG_CODE, "Entering %s\n", __FUNCTION__);
 
-    if (realmId < 0 || realmId > sConfig.GetConfig(CONFIG_REALMS_COUNT))
+    if (realmId < 0 || realmId >= realmsCount)
         return;
 
-    std::istringstream iss;
-
-    if (!err && response.status() == 200)
-        iss.str(response.body());
-    else
-        iss.str("0 0 0 0 0 0 0 0 0 0 0 0 0 0 0");
-
-    std::string online, maxOnline, rev, diff, avgDiff, queue, maxQueue, unk;
-    int tmpUp, ally = 0, horde = 0, hordePct = 0, allyPct = 0;
+    #define STATUS_CHANGED(a) (!previous || previous->a != status.a)
 
-    iss >> tmpUp;
-    iss >> online;
-    iss >> maxOnline;
-    iss >> queue;
-    iss >> maxQueue;
-    iss >> unk;
-    iss >> rev;
-    iss >> diff;
-    iss >> avgDiff;
-    iss >> ally;
-    iss >> horde;
+    int tmpUp = status.uptime, ally = status.ally, horde = status.horde, hordePct = 0, allyPct = 0;
 
     if (ally || horde)
     {
@@ -231,17 +275,82 @@ void ServerStatusPage::UpdateStatus(boost::system::error_code err, const Wt::Htt
     m = (tmpUp - d*DAY - h*HOUR)/MINUTE;
     s = tmpUp - d*DAY - h*HOUR - m*MINUTE;
 
-    WString tmpStr = Wt::WString::fromUTF8(sConfig.GetRealmInformations(realmId).name);
+    if (!previous)
+    {
+        WString tmpStr = Wt::WString::fromUTF8(sConfig.GetRealmInformations(realmId).name);
+        texts[realmId][SERVER_STATUS_TEXT_REALM]->setText(tmpStr);
+    }
 
-    texts[realmId][SERVER_STATUS_TEXT_REALM]->setText(tmpStr);
-    texts[realmId][SERVER_STATUS_TEXT_STATE]->setText(Wt::WString::tr(tmpUp ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE));
-    texts[realmId][SERVER_STATUS_TEXT_ONLINE]->setText(online);
-    texts[realmId][SERVER_STATUS_TEXT_MAXONLINE]->setText(maxOnline);
-    texts[realmId][SERVER_STATUS_TEXT_FACTIONS]->setText(Wt::WString::tr(TXT_STATUS_FACTIONS_FMT).arg(horde).arg(hordePct).arg(ally).arg(allyPct));
-    texts[realmId][SERVER_STATUS_TEXT_UPTIME]->setText(Wt::WString::tr(TXT_STATUS_UPTIME_FMT).arg(d).arg(h).arg(m).arg(s));
-    texts[realmId][SERVER_STATUS_TEXT_REVISION]->setText(rev);
-    texts[realmId][SERVER_STATUS_TEXT_DIFF]->setText(diff);
-    texts[realmId][SERVER_STATUS_TEXT_AVGDIFF]->setText(avgDiff);
+    if (!previous || previous->IsOnline() != status.IsOnline())
+        texts[realmId][SERVER_STATUS_TEXT_STATE]->setText(Wt::WString::tr(tmpUp ? TXT_GEN_ONLINE : TXT_GEN_OFFLINE));
+    if (STATUS_CHANGED(online))
+        texts[realmId][SERVER_STATUS_TEXT_ONLINE]->setText(Misc::GetFormattedString("%u", status.online));
+    if (STATUS_CHANGED(maxOnline))
+        texts[realmId][SERVER_STATUS_TEXT_MAXONLINE]->setText(Misc::GetFormattedString("%u", status.maxOnline));
+    if (STATUS_CHANGED(ally) || STATUS_CHANGED(horde))
+        texts[realmId][SERVER_STATUS_TEXT_FACTIONS]->setText(Wt::WString::tr(TXT_STATUS_FACTIONS_FMT).arg(horde).arg(hordePct).arg(ally).arg(allyPct));
+    if (STATUS_CHANGED(uptime))
+        texts[realmId][SERVER_STATUS_TEXT_UPTIME]->setText(Wt::WString::tr(TXT_STATUS_UPTIME_FMT).arg(d).arg(h).arg(m).arg(s));
+    if (STATUS_CHANGED(revision))
+        texts[realmId][SERVER_STATUS_TEXT_REVISION]->setText(status.revision);
+    if (STATUS_CHANGED(diff))
+        texts[realmId][SERVER_STATUS_TEXT_DIFF]->setText(status.diff);
+    if (STATUS_CHANGED(avgDiff))
+        texts[realmId][SERVER_STATUS_TEXT_AVGDIFF]->setText(status.avgDiff);
+
+    #undef STATUS_CHANGED
 
     Misc::Console(DEBUG_CODE, "%s End\n", __FUNCTION__);
 }
+
+/********************************************//**
+ * \brief Creates new StatusSparkline object.
+ *
+ * \param parent    Parent container type object in which this widget should be placed.
+ *
+ ***********************************************/
+
+StatusSparkline::StatusSparkline(Wt::WContainerWidget * parent)
+: Wt::WPaintedWidget(parent)
+{
+    resize(SPARKLINE_WIDTH, SPARKLINE_HEIGHT);
+    setStyleClass("sparkline");
+}
+
+void StatusSparkline::SetPoints(const StatusHistoryPointsPtr & points)
+{
+    this->points = points;
+    update();
+}
+
+void StatusSparkline::paintEvent(Wt::WPaintDevice * paintDevice)
+{
+    if (!points || points->size() < 2)
+        return;
+
+    uint32 maxValue = 1;
+
+    for (std::vector<uint32>::const_iterator itr = points->begin(); itr != points->end(); ++itr)
+        if (*itr > maxValue)
+            maxValue = *itr;
+
+    double stepX = double(SPARKLINE_WIDTH - 1) / (points->size() - 1);
+    double scaleY = double(SPARKLINE_HEIGHT - 2) / maxValue;
+
+    Wt::WPainterPath path;
+
+    for (size_t i = 0; i < points->size(); ++i)
+    {
+        double x = i * stepX;
+        double y = SPARKLINE_HEIGHT - 1 - (*points)[i] * scaleY;
+
+        if (i)
+            path.lineTo(x, y);
+        else
+            path.moveTo(x, y);
+    }
+
+    Wt::WPainter painter(paintDevice);
+    painter.setPen(Wt::WPen(Wt::WColor(SPARKLINE_COLOR)));
+    painter.drawPath(path);
+}
@@ -30,10 +30,11 @@
 #ifndef SERVERSTATUS_H_INCLUDED
 #define SERVERSTATUS_H_INCLUDED
 
-#include <boost/system/error_code.hpp>
 #include <Wt/WContainerWidget>
+#include <Wt/WPaintedWidget>
 
 #include "../defines.h"
+#include "../realmStatus.h"
 
 /********************************************//**
  * \brief Slots for server status page
@@ -58,13 +59,38 @@ enum ServerStatusTextSlots
     SERVER_STATUS_TEXT_SLOT_COUNT
 };
 
+/********************************************//**
+ * \brief Small chart of online players history.
+ *
+ * Points are shared by all sessions (see RealmStatusHistory),
+ * widget is repainted only when it gets new points.
+ *
+ ***********************************************/
+
+class StatusSparkline : public Wt::WPaintedWidget
+{
+public:
+    StatusSparkline(Wt::WContainerWidget * parent = 0);
+
+    void SetPoints(const StatusHistoryPointsPtr & points);
+    const StatusHistoryPointsPtr & GetPoints() const { return points; }
+
+protected:
+    void paintEvent(Wt::WPaintDevice * paintDevice);
+
+private:
+    /// online players values to draw
+    StatusHistoryPointsPtr points;
+};
+
 /********************************************//**
  * \brief A class to represent Server status page.
  *
  * This class is container for widgets contains
  * text and data for server status page.
  * Text depends on language and is stored in DB.
- * Data are parsed from server output file.
+ * Data are taken from status snapshots shared by all sessions
+ * (see RealmStatusPoller).
  *
  ***********************************************/
 
@@ -76,18 +102,22 @@ public:
 
     void refresh();
 private:
-    /// status refresh timer
-    Wt::WTimer * timer;
+    /// status changes subscription, 0 while page isn't shown
+    uint32 subscription;
     /// tables for multiple realm status
     Wt::WTable ** realms;
-    /// http clients for multiple realms
-    Wt::Http::Client ** clients;
     /// text widgets for tables
     Wt::WText *** texts;
+    /// history charts for tables
+    StatusSparkline *** sparklines;
+    /// count of realms for which tables were created
+    int realmsCount;
+    /// status snapshots currently shown
+    RealmStatusPtr * shown;
 
     void CreateStatusPage();
     void RunUpdateStatus();
-    void UpdateStatus(boost::system::error_code err, const Wt::Http::Message& response, int realmId);
+    void UpdateStatus(const RealmStatus & status, const RealmStatus * previous, int realmId);
 };
 
 #endif // SERVERSTATUS_H_INCLUDED
@@ -37,6 +37,7 @@
 #include "../config.h"
 #include "../database.h"
 #include "../misc.h"
+#include "../miscAccount.h"
 #include "../miscCharacter.h"
 
 TeleportPage::TeleportPage(SessionInfo * sess, Wt::WContainerWidget * parent):
@@ -111,17 +112,17 @@ void TeleportPage::LoadCharacters()
 
         if (db.ExecuteQuery() > DB_RESULT_EMPTY)
         {
-            std::list<DatabaseRow*> rows = db.GetRows();
+            const std::vector<DatabaseRow> & rows = db.GetRows();
             db.Disconnect();
 
-            DatabaseRow * tmpRow;
+            const DatabaseRow * tmpRow;
 
             guids = new uint64[rows.size()];
             int i = 0;
 
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
+            for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr, ++i)
             {
-                tmpRow = *itr;
+                tmpRow = &*itr;
 
                 guids[i] = tmpRow->fields[0].GetUInt64();
 
@@ -206,11 +207,8 @@ void TeleportPage::Teleport()
 
     teleInfo->setText(tr(teleportStatus));
 
-    if (db.Connect(DB_PANEL_DATA))
-    {
-        std::string tmpStr = Misc::GetFormattedString("Teleport. Character: %s. success: %s", db.EscapeString(name).c_str(), success ? "Yes" : "No");
-        db.ExecutePQuery("INSERT INTO Activity VALUES ('%u', NOW(), '%s', '', '%s')", session->accountId, session->sessionIp.toUTF8().c_str(), tmpStr.c_str());
-    }
+    std::string tmpStr = Misc::GetFormattedString("Teleport. Character: %s. success: %s", name.toUTF8().c_str(), success ? "Yes" : "No");
+    Misc::Account::AddActivity(session->accountId, session->sessionIp.toUTF8(), "", tmpStr);
 }
 
 /********************************************//**
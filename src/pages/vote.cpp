@@ -141,12 +141,12 @@ void VotePage::CreateVotePage()
         case DB_RESULT_EMPTY:
         default:
         {
-            std::list<DatabaseRow*> rows = db.GetRows();
-            DatabaseRow * tmpRow;
+            const std::vector<DatabaseRow> & rows = db.GetRows();
+            const DatabaseRow * tmpRow;
 
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+            for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
             {
-                tmpRow = *itr;
+                tmpRow = &*itr;
 
                 VoteInfo tmpInfo;
                 tmpInfo.voteId = tmpRow->fields[0].GetUInt32();
@@ -175,11 +175,11 @@ void VotePage::CreateVotePage()
         case DB_RESULT_EMPTY:
         default:
         {
-            std::list<DatabaseRow*> rows = db.GetRows();
-            DatabaseRow * tmpRow;
-            for (std::list<DatabaseRow*>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+            const std::vector<DatabaseRow> & rows = db.GetRows();
+            const DatabaseRow * tmpRow;
+            for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
             {
-                tmpRow = *itr;
+                tmpRow = &*itr;
 
                 for (std::list<VoteInfo>::iterator vItr = votesInfo.begin(); vItr != votesInfo.end(); ++vItr)
                 {
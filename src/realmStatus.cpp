@@ -0,0 +1,421 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "realmStatus.h"
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+
+#include <Wt/Http/Client>
+#include <Wt/Http/Message>
+#include <Wt/WApplication>
+#include <Wt/WServer>
+
+#include "config.h"
+#include "misc.h"
+
+// history file header: magic, version, sample size, realms count
+#define STATUS_HISTORY_HEADER_SIZE  4
+#define STATUS_HISTORY_MAGIC        0x48475348
+#define STATUS_HISTORY_VERSION      1
+
+bool RealmStatus::HasSameValues(const RealmStatus & status) const
+{
+    return uptime == status.uptime && online == status.online && maxOnline == status.maxOnline &&
+           queue == status.queue && maxQueue == status.maxQueue && revision == status.revision &&
+           diff == status.diff && avgDiff == status.avgDiff && ally == status.ally && horde == status.horde;
+}
+
+RealmStatusPoller::RealmStatusPoller()
+    : stopping(false), nextSubscriptionId(1)
+{
+    realms.resize(sConfig.GetConfig(CONFIG_REALMS_COUNT));
+
+    LoadHistory();
+
+    poller = std::thread(&RealmStatusPoller::Run, this);
+}
+
+RealmStatusPoller::~RealmStatusPoller()
+{
+    Stop();
+}
+
+RealmStatusPoller & RealmStatusPoller::Instance()
+{
+    // same as in Config::Instance()
+    if (_poller == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_poller == nullptr)
+            _poller = new RealmStatusPoller();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<RealmStatusPoller*>(_poller);
+}
+
+void RealmStatusPoller::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(_createMutex);
+
+    if (_poller != nullptr)
+        const_cast<RealmStatusPoller*>(_poller)->Stop();
+}
+
+void RealmStatusPoller::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        stopping = true;
+    }
+
+    pollCondition.notify_all();
+
+    if (poller.joinable())
+    {
+        poller.join();
+        SaveHistory();
+    }
+
+    // clients use server io service, so they must be destroyed before server stops (pending requests are aborted)
+    std::vector<Wt::Http::Client*> clients;
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+
+        for (std::vector<RealmPoll>::iterator itr = realms.begin(); itr != realms.end(); ++itr)
+        {
+            if (itr->client)
+                clients.push_back(itr->client);
+
+            itr->client = NULL;
+            itr->pending = false;
+        }
+    }
+
+    for (std::vector<Wt::Http::Client*>::iterator itr = clients.begin(); itr != clients.end(); ++itr)
+    {
+        (*itr)->abort();
+        delete *itr;
+    }
+}
+
+void RealmStatusPoller::Run()
+{
+    std::unique_lock<std::mutex> lock(statusMutex);
+
+    while (!stopping)
+    {
+        lock.unlock();
+        Poll();
+        lock.lock();
+
+        int interval = sConfig.GetConfig(CONFIG_INTERVAL_UPDATE_STATUS);
+
+        pollCondition.wait_for(lock, std::chrono::seconds(interval > 0 ? interval : MINUTE));
+    }
+}
+
+void RealmStatusPoller::Poll()
+{
+    Wt::WServer * server = Wt::WServer::instance();
+
+    if (!server)
+        return;
+
+    int realmsCount = sConfig.GetConfig(CONFIG_REALMS_COUNT);
+    int timeout = sConfig.GetConfig(CONFIG_INTERVAL_STATUS_TIMEOUT);
+
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    // realms count can grow after config reload
+    if (int(realms.size()) < realmsCount)
+        realms.resize(realmsCount);
+
+    for (int i = 0; i < realmsCount; ++i)
+    {
+        RealmPoll & realm = realms[i];
+
+        // previous request will end with timeout
+        if (realm.pending)
+            continue;
+
+        if (!realm.client)
+        {
+            realm.client = new Wt::Http::Client(server->ioService());
+            realm.client->done().connect(boost::bind(&RealmStatusPoller::Done, this, _1, _2, i));
+        }
+
+        realm.client->setTimeout(timeout > 0 ? timeout : 15);
+
+        realm.requestTime = std::chrono::steady_clock::now();
+        realm.pending = realm.client->get(sConfig.GetRealmInformations(i).statusUrl);
+
+        if (!realm.pending)
+        {
+            ++realm.stats.failed;
+            Misc::Console(DEBUG_CODE, "%s: can't request status for realm %i\n", __FUNCTION__, i);
+        }
+    }
+}
+
+void RealmStatusPoller::Done(boost::system::error_code err, const Wt::Http::Message & response, int realmId)
+{
+    bool success = !err && response.status() == 200;
+
+    // parse outside of lock, realm is shown as offline when status can't be fetched
+    RealmStatus * status = Parse(success ? response.body() : std::string());
+    status->updateTime = std::time(NULL);
+
+    bool changed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+
+        // aborted on shutdown
+        if (stopping || realmId < 0 || realmId >= int(realms.size()))
+        {
+            delete status;
+            return;
+        }
+
+        RealmPoll & realm = realms[realmId];
+
+        realm.pending = false;
+
+        // unchanged status keeps old snapshot, so sessions don't have to update anything
+        if (realm.status->updateTime && realm.status->HasSameValues(*status))
+            delete status;
+        else
+        {
+            realm.status = RealmStatusPtr(status);
+            changed = true;
+        }
+
+        if (success)
+            UpdateStats(realm);
+        else
+            ++realm.stats.failed;
+
+        realm.history.Add(*realm.status, std::time(NULL));
+    }
+
+    if (changed)
+        Notify();
+}
+
+void RealmStatusPoller::UpdateStats(RealmPoll & realm)
+{
+    uint32 latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - realm.requestTime).count();
+
+    ++realm.stats.fetched;
+    realm.stats.lastLatency = latency;
+    realm.stats.totalLatency += latency;
+    if (latency > realm.stats.maxLatency)
+        realm.stats.maxLatency = latency;
+}
+
+RealmStatus * RealmStatusPoller::Parse(const std::string & body)
+{
+    RealmStatus * status = new RealmStatus();
+
+    // offline realm is shown with zeros
+    std::istringstream iss(body.empty() ? "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0" : body);
+    std::string unk;
+
+    iss >> status->uptime;
+    iss >> status->online;
+    iss >> status->maxOnline;
+    iss >> status->queue;
+    iss >> status->maxQueue;
+    iss >> unk;
+    iss >> status->revision;
+    iss >> status->diff;
+    iss >> status->avgDiff;
+    iss >> status->ally;
+    iss >> status->horde;
+
+    return status;
+}
+
+uint32 RealmStatusPoller::Subscribe(const Listener & listener)
+{
+    Wt::WApplication * app = Wt::WApplication::instance();
+
+    if (!app)
+    {
+        Misc::Console(DEBUG_CODE, "%s: called outside of session\n", __FUNCTION__);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    uint32 id = nextSubscriptionId++;
+
+    Subscription & subscription = subscriptions[id];
+    subscription.sessionId = app->sessionId();
+    subscription.listener = listener;
+
+    return id;
+}
+
+void RealmStatusPoller::Unsubscribe(uint32 id)
+{
+    std::lock_guard<std::mutex> lock(statusMutex);
+    subscriptions.erase(id);
+}
+
+void RealmStatusPoller::Notify()
+{
+    Wt::WServer * server = Wt::WServer::instance();
+
+    if (!server)
+        return;
+
+    std::vector<std::pair<uint32, std::string> > sessions;
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+
+        if (stopping)
+            return;
+
+        sessions.reserve(subscriptions.size());
+
+        for (std::map<uint32, Subscription>::const_iterator itr = subscriptions.begin(); itr != subscriptions.end(); ++itr)
+            sessions.push_back(std::make_pair(itr->first, itr->second.sessionId));
+    }
+
+    for (std::vector<std::pair<uint32, std::string> >::const_iterator itr = sessions.begin(); itr != sessions.end(); ++itr)
+    {
+        uint32 id = itr->first;
+
+        // closed session ignores post, listener is checked again in session context because page could be deleted meanwhile
+        server->post(itr->second, [id]()
+        {
+            RealmStatusPoller::Instance().CallListener(id);
+        });
+    }
+}
+
+void RealmStatusPoller::CallListener(uint32 id)
+{
+    Listener listener;
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+
+        std::map<uint32, Subscription>::const_iterator itr = subscriptions.find(id);
+        if (itr == subscriptions.end())
+            return;
+
+        listener = itr->second.listener;
+    }
+
+    listener();
+
+    if (Wt::WApplication * app = Wt::WApplication::instance())
+        app->triggerUpdate();
+}
+
+RealmStatusPtr RealmStatusPoller::GetStatus(int realmId)
+{
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    if (realmId < 0 || realmId >= int(realms.size()))
+        return RealmStatusPtr(new RealmStatus());
+
+    return realms[realmId].status;
+}
+
+RealmStatusStats RealmStatusPoller::GetStats(int realmId)
+{
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    if (realmId < 0 || realmId >= int(realms.size()))
+        return RealmStatusStats();
+
+    return realms[realmId].stats;
+}
+
+StatusHistoryPointsPtr RealmStatusPoller::GetHistoryPoints(int realmId, StatusHistoryTier tier)
+{
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    if (realmId < 0 || realmId >= int(realms.size()) || tier >= STATUS_HISTORY_TIER_COUNT)
+        return StatusHistoryPointsPtr(new std::vector<uint32>());
+
+    return realms[realmId].history.GetOnlinePoints(tier);
+}
+
+void RealmStatusPoller::LoadHistory()
+{
+    std::ifstream file(sConfig.GetConfig(CONFIG_STATUS_HISTORY_FILE).c_str(), std::ios::binary);
+
+    if (!file)
+        return;
+
+    uint32 header[STATUS_HISTORY_HEADER_SIZE];
+
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+        header[0] != STATUS_HISTORY_MAGIC || header[1] != STATUS_HISTORY_VERSION || header[2] != sizeof(StatusSample))
+    {
+        Misc::Console(DEBUG_CODE, "%s: status history file has wrong format\n", __FUNCTION__);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    // realms count could be changed since last run
+    for (uint32 i = 0; i < header[3] && i < realms.size(); ++i)
+    {
+        if (!realms[i].history.Load(file))
+        {
+            Misc::Console(DEBUG_CODE, "%s: status history file is broken\n", __FUNCTION__);
+            realms[i].history = RealmStatusHistory();
+            return;
+        }
+    }
+}
+
+void RealmStatusPoller::SaveHistory()
+{
+    std::ofstream file(sConfig.GetConfig(CONFIG_STATUS_HISTORY_FILE).c_str(), std::ios::binary | std::ios::trunc);
+
+    if (!file)
+    {
+        Misc::Console(DEBUG_CODE, "%s: can't write status history file\n", __FUNCTION__);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(statusMutex);
+
+    uint32 header[STATUS_HISTORY_HEADER_SIZE] = { STATUS_HISTORY_MAGIC, STATUS_HISTORY_VERSION, sizeof(StatusSample), uint32(realms.size()) };
+
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (std::vector<RealmPoll>::const_iterator itr = realms.begin(); itr != realms.end(); ++itr)
+        itr->history.Save(file);
+}
+
+volatile RealmStatusPoller * RealmStatusPoller::_poller = nullptr;
+std::mutex RealmStatusPoller::_createMutex;
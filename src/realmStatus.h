@@ -0,0 +1,175 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REALM_STATUS_H_INCLUDED
+#define REALM_STATUS_H_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/system/error_code.hpp>
+
+#include "defines.h"
+#include "statusHistory.h"
+
+namespace Wt
+{
+    namespace Http
+    {
+        class Client;
+        class Message;
+    }
+}
+
+/********************************************//**
+ * \brief Parsed realm status file.
+ *
+ * Snapshots are never changed after publishing
+ * so they can be shared by all sessions.
+ *
+ ***********************************************/
+
+struct RealmStatus
+{
+    RealmStatus() : uptime(0), online(0), maxOnline(0), queue(0), maxQueue(0), revision("0"), diff("0"), avgDiff("0"), ally(0), horde(0), updateTime(0) {}
+
+    bool IsOnline() const { return uptime != 0; }
+    bool HasSameValues(const RealmStatus & status) const;   /// compares all values except update time
+
+    uint32 uptime;              /// realm uptime in seconds, 0 when realm is offline or status can't be fetched
+    uint32 online;
+    uint32 maxOnline;
+    uint32 queue;
+    uint32 maxQueue;
+    std::string revision;
+    std::string diff;           /// average diff from last minute
+    std::string avgDiff;        /// average diff from last restart
+    uint32 ally;                /// alliance players online
+    uint32 horde;               /// horde players online
+    std::time_t updateTime;     /// time when these values were fetched first, 0 when status wasn't fetched yet
+};
+
+typedef std::shared_ptr<const RealmStatus> RealmStatusPtr;
+
+/********************************************//**
+ * \brief Realm status fetching statistics.
+ ***********************************************/
+
+struct RealmStatusStats
+{
+    RealmStatusStats() : fetched(0), failed(0), lastLatency(0), maxLatency(0), totalLatency(0) {}
+
+    uint32 GetAverageLatency() const { return fetched ? totalLatency / fetched : 0; }
+
+    uint64 fetched;             /// count of successful fetches
+    uint64 failed;              /// count of failed fetches (errors, timeouts, wrong http status)
+    uint32 lastLatency;         /// time (ms) of last successful fetch
+    uint32 maxLatency;          /// longest time (ms) of successful fetch
+    uint64 totalLatency;
+};
+
+/********************************************//**
+ * \brief Process wide realms status poller.
+ *
+ * Poller thread fetches status file of each realm
+ * every configured interval and publishes parsed
+ * snapshot. Pages only read last snapshot so status
+ * url is requested once per interval no matter how
+ * many sessions are open.
+ * Sessions can subscribe for changes - listener is
+ * posted to session (WServer::post) only when some
+ * status value was changed.
+ * Every fetched status is also added to realm history
+ * which is saved to file on shutdown.
+ *
+ ***********************************************/
+
+class RealmStatusPoller
+{
+public:
+    static RealmStatusPoller & Instance();
+    static void Shutdown();                             /// stops poller thread (if poller was created)
+
+    RealmStatusPtr GetStatus(int realmId);              /// returns last status of realm, never NULL
+    RealmStatusStats GetStats(int realmId);             /// returns fetching statistics of realm
+    StatusHistoryPointsPtr GetHistoryPoints(int realmId, StatusHistoryTier tier); /// returns online players history for sparkline, never NULL
+
+    typedef std::function<void ()> Listener;
+
+    uint32 Subscribe(const Listener & listener);        /// subscribes current session for status changes, returns subscription id (0 on error)
+    void Unsubscribe(uint32 id);                        /// should be called from session which subscribed
+
+private:
+    RealmStatusPoller();
+    RealmStatusPoller(const RealmStatusPoller &) {}
+    ~RealmStatusPoller();
+
+    struct RealmPoll
+    {
+        RealmPoll() : client(NULL), pending(false), status(new RealmStatus()) {}
+
+        Wt::Http::Client * client;
+        bool pending;                                   /// request wasn't finished yet
+        std::chrono::steady_clock::time_point requestTime;
+        RealmStatusPtr status;
+        RealmStatusStats stats;
+        RealmStatusHistory history;
+    };
+
+    void Run();                                         /// poller thread loop
+    void Stop();
+    void Poll();                                        /// sends status requests for all realms
+    void Done(boost::system::error_code err, const Wt::Http::Message & response, int realmId);
+    void UpdateStats(RealmPoll & realm);                /// updates statistics after successful fetch, should be called with locked statusMutex
+    void Notify();                                      /// posts listeners to subscribed sessions
+    void CallListener(uint32 id);                       /// calls listener if it's still subscribed, called in session context
+    void LoadHistory();                                 /// loads history saved on last shutdown
+    void SaveHistory();
+
+    static RealmStatus * Parse(const std::string & body); /// parses status file
+
+    struct Subscription
+    {
+        std::string sessionId;
+        Listener listener;
+    };
+
+    std::vector<RealmPoll> realms;
+    bool stopping;
+
+    std::map<uint32, Subscription> subscriptions;
+    uint32 nextSubscriptionId;
+
+    std::thread poller;
+    std::mutex statusMutex;
+    std::condition_variable pollCondition;
+
+    static volatile RealmStatusPoller * _poller;
+    static std::mutex _createMutex;
+};
+
+#define sRealmStatusPoller RealmStatusPoller::Instance()
+
+#endif // REALM_STATUS_H_INCLUDED
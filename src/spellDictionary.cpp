@@ -0,0 +1,165 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "spellDictionary.h"
+
+#include <algorithm>
+
+#include "config.h"
+#include "database.h"
+#include "misc.h"
+
+#define SPELLS_LOAD_RETRY_DELAY     MINUTE
+
+const SpellEntry * SpellTable::Find(uint32 entry) const
+{
+    SpellEntry spell;
+    spell.entry = entry;
+
+    std::vector<SpellEntry>::const_iterator itr = std::lower_bound(entries.begin(), entries.end(), spell);
+
+    if (itr == entries.end() || itr->entry != entry)
+        return NULL;
+
+    return &*itr;
+}
+
+Wt::WString SpellTable::GetName(uint32 entry) const
+{
+    const SpellEntry * spell = Find(entry);
+
+    if (!spell)
+        return Wt::WString();
+
+    return Wt::WString::fromUTF8(names.substr(spell->nameOffset, spell->nameLength));
+}
+
+SpellDictionary::SpellDictionary() : loading(false)
+{
+    spells = SpellTablePtr(Load());
+    loaded = spells != nullptr;
+
+    if (!loaded)
+    {
+        spells = SpellTablePtr(new SpellTable());
+        nextLoadTime = std::chrono::steady_clock::now() + std::chrono::seconds(SPELLS_LOAD_RETRY_DELAY);
+    }
+}
+
+SpellDictionary & SpellDictionary::Instance()
+{
+    // same as in Config::Instance()
+    if (_dictionary == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_dictionary == nullptr)
+            _dictionary = new SpellDictionary();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<SpellDictionary*>(_dictionary);
+}
+
+SpellTable * SpellDictionary::Load()
+{
+    Database db;
+    if (!db.Connect(DB_PANEL_DATA))
+        return NULL;
+
+    // spells table is big, so read it row by row instead of storing whole result
+    DatabaseCursor cursor;
+    if (!db.ExecuteStreamQuery("SELECT entry, name FROM spells", cursor))
+        return NULL;
+
+    SpellTable * table = new SpellTable();
+
+    DatabaseRow * tmpRow;
+    SpellEntry spell;
+    while (cursor.Next())
+    {
+        tmpRow = cursor.GetRow();
+
+        spell.entry = tmpRow->fields[0].GetUInt32();
+        spell.nameOffset = table->names.size();
+        spell.nameLength = tmpRow->fields[1].GetLength();
+
+        table->names.append(tmpRow->fields[1].GetCString(), spell.nameLength);
+        table->entries.push_back(spell);
+    }
+
+    // partially loaded spells aren't published so next call will try again
+    if (cursor.HasError())
+    {
+        delete table;
+        return NULL;
+    }
+
+    // stable sort keeps rows order for duplicated ids, last one is used same as in old map
+    std::stable_sort(table->entries.begin(), table->entries.end());
+
+    std::vector<SpellEntry>::iterator last = table->entries.begin();
+
+    for (std::vector<SpellEntry>::const_iterator itr = table->entries.begin(); itr != table->entries.end(); ++itr)
+    {
+        if (last != table->entries.begin() && (last - 1)->entry == itr->entry)
+            *(last - 1) = *itr;
+        else
+            *last++ = *itr;
+    }
+
+    table->entries.erase(last, table->entries.end());
+    table->entries.shrink_to_fit();
+    table->names.shrink_to_fit();
+
+    Misc::Console(DEBUG_CODE, "%s: loaded %u spells, names size: %u\n", __FUNCTION__, uint32(table->entries.size()), uint32(table->names.size()));
+
+    return table;
+}
+
+SpellTablePtr SpellDictionary::GetSpells()
+{
+    {
+        std::lock_guard<std::mutex> lock(spellsMutex);
+
+        // while db is unavailable load is tried only by one caller once per delay
+        if (loaded || loading || std::chrono::steady_clock::now() < nextLoadTime)
+            return spells;
+
+        loading = true;
+    }
+
+    SpellTable * table = Load();
+
+    std::lock_guard<std::mutex> lock(spellsMutex);
+
+    loading = false;
+
+    if (table)
+    {
+        spells = SpellTablePtr(table);
+        loaded = true;
+    }
+    else
+        nextLoadTime = std::chrono::steady_clock::now() + std::chrono::seconds(SPELLS_LOAD_RETRY_DELAY);
+
+    return spells;
+}
+
+volatile SpellDictionary * SpellDictionary::_dictionary = nullptr;
+std::mutex SpellDictionary::_createMutex;
@@ -0,0 +1,101 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SPELL_DICTIONARY_H_INCLUDED
+#define SPELL_DICTIONARY_H_INCLUDED
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "defines.h"
+
+/********************************************//**
+ * \brief Spell entry in SpellTable.
+ ***********************************************/
+
+struct SpellEntry
+{
+    uint32 entry;                                       /// spell id
+    uint32 nameOffset;                                  /// name position in SpellTable::names
+    uint32 nameLength;                                  /// name length in bytes
+
+    bool operator<(const SpellEntry & spell) const { return entry < spell.entry; }
+};
+
+/********************************************//**
+ * \brief Immutable spells table.
+ *
+ * Entries are sorted by spell id and all names
+ * are stored in one buffer, so whole table takes
+ * 12 bytes per spell plus names length.
+ *
+ ***********************************************/
+
+struct SpellTable
+{
+    std::vector<SpellEntry> entries;
+    std::string names;                                  /// names of all spells (without separators)
+
+    const SpellEntry * Find(uint32 entry) const;        /// returns spell with given id or NULL
+    Wt::WString GetName(uint32 entry) const;            /// returns spell name or empty string for unknown spell
+};
+
+typedef std::shared_ptr<const SpellTable> SpellTablePtr;
+
+/********************************************//**
+ * \brief Process wide spells dictionary.
+ *
+ * Spells are loaded from panel db once (on start)
+ * and published as immutable table which can be
+ * read from all threads without locking.
+ * When loading fails, it's repeated by GetSpells()
+ * not more often than once per minute
+ * and other callers get empty table meanwhile.
+ *
+ ***********************************************/
+
+class SpellDictionary
+{
+public:
+    static SpellDictionary & Instance();
+
+    SpellTablePtr GetSpells();                          /// returns spells table, never NULL (empty when spells couldn't be loaded)
+
+private:
+    SpellDictionary();
+    SpellDictionary(const SpellDictionary &) {}
+    ~SpellDictionary() {}
+
+    static SpellTable * Load();                         /// returns NULL when spells couldn't be loaded
+
+    SpellTablePtr spells;
+    bool loaded;
+    bool loading;                                       /// load is executed by other thread (without lock)
+    std::chrono::steady_clock::time_point nextLoadTime; /// load isn't retried before this time
+
+    std::mutex spellsMutex;
+
+    static volatile SpellDictionary * _dictionary;
+    static std::mutex _createMutex;
+};
+
+#define sSpellDictionary SpellDictionary::Instance()
+
+#endif // SPELL_DICTIONARY_H_INCLUDED
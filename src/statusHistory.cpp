@@ -0,0 +1,245 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "statusHistory.h"
+
+#include <cstdlib>
+
+#include "realmStatus.h"
+
+#define STATUS_HISTORY_QUARTER      (15 * MINUTE)
+#define STATUS_HISTORY_DAY_SIZE     (DAY / MINUTE)
+#define STATUS_HISTORY_MONTH_SIZE   (MONTH / STATUS_HISTORY_QUARTER)
+#define STATUS_HISTORY_POINTS       144
+
+static uint16 ClampSample(uint32 value)
+{
+    return value > 0xFFFF ? 0xFFFF : value;
+}
+
+StatusSampleRing::StatusSampleRing(uint32 capacity)
+    : samples(capacity), first(0), count(0)
+{
+}
+
+void StatusSampleRing::Add(const StatusSample & sample)
+{
+    if (count < samples.size())
+    {
+        samples[(first + count) % samples.size()] = sample;
+        ++count;
+        return;
+    }
+
+    // overwrite the oldest sample
+    samples[first] = sample;
+    first = (first + 1) % samples.size();
+}
+
+void StatusSampleRing::ReplaceLast(const StatusSample & sample)
+{
+    if (!count)
+    {
+        Add(sample);
+        return;
+    }
+
+    samples[(first + count - 1) % samples.size()] = sample;
+}
+
+const StatusSample & StatusSampleRing::Get(uint32 index) const
+{
+    return samples[(first + index) % samples.size()];
+}
+
+const StatusSample * StatusSampleRing::GetLast() const
+{
+    return count ? &Get(count - 1) : NULL;
+}
+
+RealmStatusHistory::RealmStatusHistory()
+    : minutes(STATUS_HISTORY_DAY_SIZE), quarters(STATUS_HISTORY_MONTH_SIZE)
+{
+    UpdatePoints();
+}
+
+StatusSample RealmStatusHistory::MakeSample(const RealmStatus & status, std::time_t time)
+{
+    StatusSample sample;
+
+    sample.time = time - time % MINUTE;
+    sample.uptime = status.uptime;
+    sample.online = ClampSample(status.online);
+    sample.maxOnline = ClampSample(status.maxOnline);
+    sample.queue = ClampSample(status.queue);
+    sample.diff = ClampSample(atoi(status.diff.c_str()));
+    sample.avgDiff = ClampSample(atoi(status.avgDiff.c_str()));
+    sample.ally = ClampSample(status.ally);
+    sample.horde = ClampSample(status.horde);
+    sample.unused = 0;
+
+    return sample;
+}
+
+void RealmStatusHistory::Add(const RealmStatus & status, std::time_t time)
+{
+    StatusSample sample = MakeSample(status, time);
+    const StatusSample * last = minutes.GetLast();
+
+    if (last && last->time == sample.time)
+        minutes.ReplaceLast(sample);
+    else
+    {
+        if (last && last->time / STATUS_HISTORY_QUARTER != sample.time / STATUS_HISTORY_QUARTER)
+            CloseQuarter(last->time / STATUS_HISTORY_QUARTER);
+
+        minutes.Add(sample);
+    }
+
+    UpdatePoints();
+}
+
+void RealmStatusHistory::CloseQuarter(uint32 quarter)
+{
+    const StatusSample * last = quarters.GetLast();
+
+    if (last && last->time >= quarter * STATUS_HISTORY_QUARTER)
+        return;
+
+    uint32 count = 0, online = 0, queue = 0, diff = 0, avgDiff = 0, ally = 0, horde = 0;
+    StatusSample sample = StatusSample();
+
+    // samples from given quarter are at the end of day tier
+    for (uint32 i = minutes.GetCount(); i > 0; --i)
+    {
+        const StatusSample & minute = minutes.Get(i - 1);
+
+        if (minute.time / STATUS_HISTORY_QUARTER != quarter)
+            break;
+
+        if (!count)
+            sample.uptime = minute.uptime;
+
+        if (minute.maxOnline > sample.maxOnline)
+            sample.maxOnline = minute.maxOnline;
+
+        online += minute.online;
+        queue += minute.queue;
+        diff += minute.diff;
+        avgDiff += minute.avgDiff;
+        ally += minute.ally;
+        horde += minute.horde;
+        ++count;
+    }
+
+    if (!count)
+        return;
+
+    sample.time = quarter * STATUS_HISTORY_QUARTER;
+    sample.online = online / count;
+    sample.queue = queue / count;
+    sample.diff = diff / count;
+    sample.avgDiff = avgDiff / count;
+    sample.ally = ally / count;
+    sample.horde = horde / count;
+
+    quarters.Add(sample);
+}
+
+void RealmStatusHistory::UpdatePoints()
+{
+    const StatusSample * last = minutes.GetLast();
+    uint32 now = last ? last->time : 0;
+
+    for (int tier = STATUS_HISTORY_DAY; tier < STATUS_HISTORY_TIER_COUNT; ++tier)
+    {
+        const StatusSampleRing * ring = GetRing(StatusHistoryTier(tier));
+        uint32 span = tier == STATUS_HISTORY_DAY ? DAY : MONTH;
+        uint32 start = now > span ? now - span : 0;
+        uint32 bucketLength = span / STATUS_HISTORY_POINTS;
+
+        std::vector<uint32> sums(STATUS_HISTORY_POINTS, 0), counts(STATUS_HISTORY_POINTS, 0);
+
+        for (uint32 i = 0; i < ring->GetCount(); ++i)
+        {
+            const StatusSample & sample = ring->Get(i);
+
+            if (sample.time < start)
+                continue;
+
+            uint32 bucket = (sample.time - start) / bucketLength;
+            if (bucket >= STATUS_HISTORY_POINTS)
+                bucket = STATUS_HISTORY_POINTS - 1;
+
+            sums[bucket] += sample.online;
+            ++counts[bucket];
+        }
+
+        std::vector<uint32> * tierPoints = new std::vector<uint32>(STATUS_HISTORY_POINTS, 0);
+
+        for (int i = 0; i < STATUS_HISTORY_POINTS; ++i)
+            if (counts[i])
+                (*tierPoints)[i] = sums[i] / counts[i];
+
+        points[tier] = StatusHistoryPointsPtr(tierPoints);
+    }
+}
+
+void RealmStatusHistory::Save(std::ostream & stream) const
+{
+    for (int tier = STATUS_HISTORY_DAY; tier < STATUS_HISTORY_TIER_COUNT; ++tier)
+    {
+        const StatusSampleRing * ring = GetRing(StatusHistoryTier(tier));
+        uint32 count = ring->GetCount();
+
+        stream.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+        // oldest samples first so loading is just adding them again
+        for (uint32 i = 0; i < count; ++i)
+            stream.write(reinterpret_cast<const char*>(&ring->Get(i)), sizeof(StatusSample));
+    }
+}
+
+bool RealmStatusHistory::Load(std::istream & stream)
+{
+    for (int tier = STATUS_HISTORY_DAY; tier < STATUS_HISTORY_TIER_COUNT; ++tier)
+    {
+        StatusSampleRing * ring = GetRing(StatusHistoryTier(tier));
+        uint32 count = 0;
+
+        if (!stream.read(reinterpret_cast<char*>(&count), sizeof(count)))
+            return false;
+
+        // broken file, ring would keep only newest samples anyway
+        if (count > ring->GetCapacity() * 4)
+            return false;
+
+        StatusSample sample;
+
+        for (uint32 i = 0; i < count; ++i)
+        {
+            if (!stream.read(reinterpret_cast<char*>(&sample), sizeof(StatusSample)))
+                return false;
+
+            ring->Add(sample);
+        }
+    }
+
+    UpdatePoints();
+
+    return true;
+}
@@ -0,0 +1,129 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATUS_HISTORY_H_INCLUDED
+#define STATUS_HISTORY_H_INCLUDED
+
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "defines.h"
+
+struct RealmStatus;
+
+/********************************************//**
+ * \brief History tiers - each has own resolution and length.
+ ***********************************************/
+
+enum StatusHistoryTier
+{
+    STATUS_HISTORY_DAY      = 0,    /**< One sample per minute from last 24 hours. */
+    STATUS_HISTORY_MONTH,           /**< One sample per 15 minutes from last 30 days. */
+
+    STATUS_HISTORY_TIER_COUNT
+};
+
+/********************************************//**
+ * \brief Packed realm status sample.
+ ***********************************************/
+
+struct StatusSample
+{
+    uint32 time;                /// sample start time (unix timestamp)
+    uint32 uptime;
+    uint16 online;
+    uint16 maxOnline;
+    uint16 queue;
+    uint16 diff;
+    uint16 avgDiff;
+    uint16 ally;
+    uint16 horde;
+    uint16 unused;              /// keeps size same on all platforms
+};
+
+/********************************************//**
+ * \brief Fixed size ring of samples.
+ *
+ * When ring is full new sample overwrites the oldest one.
+ *
+ ***********************************************/
+
+class StatusSampleRing
+{
+public:
+    explicit StatusSampleRing(uint32 capacity);
+
+    void Add(const StatusSample & sample);
+    void ReplaceLast(const StatusSample & sample);      /// changes newest sample (or adds sample to empty ring)
+
+    uint32 GetCount() const { return count; }
+    uint32 GetCapacity() const { return samples.size(); }
+    const StatusSample & Get(uint32 index) const;       /// returns sample by index, 0 is the oldest one
+    const StatusSample * GetLast() const;               /// returns newest sample or NULL when ring is empty
+
+private:
+    std::vector<StatusSample> samples;
+    uint32 first;                                       /// index of the oldest sample
+    uint32 count;
+};
+
+typedef std::shared_ptr<const std::vector<uint32> > StatusHistoryPointsPtr;
+
+/********************************************//**
+ * \brief Realm status history.
+ *
+ * Keeps samples in rings with fixed size so memory usage
+ * doesn't depend on process uptime. Every status is stored
+ * in day tier (last sample is replaced when status for
+ * same minute is added), month tier gets averaged samples
+ * from day tier when 15 minutes period is finished.
+ * Points for sparklines (online players) are prepared
+ * once after each change and shared by all sessions.
+ *
+ * Class isn't thread safe - owner (RealmStatusPoller)
+ * has to guard it.
+ *
+ ***********************************************/
+
+class RealmStatusHistory
+{
+public:
+    RealmStatusHistory();
+
+    void Add(const RealmStatus & status, std::time_t time);
+
+    StatusHistoryPointsPtr GetOnlinePoints(StatusHistoryTier tier) const { return points[tier]; }
+
+    void Save(std::ostream & stream) const;
+    bool Load(std::istream & stream);                   /// returns false when stream contains invalid data
+
+private:
+    static StatusSample MakeSample(const RealmStatus & status, std::time_t time);
+    void CloseQuarter(uint32 quarter);                  /// adds average of day samples from given 15 minutes period to month tier
+    void UpdatePoints();
+
+    StatusSampleRing * GetRing(StatusHistoryTier tier) { return tier == STATUS_HISTORY_DAY ? &minutes : &quarters; }
+    const StatusSampleRing * GetRing(StatusHistoryTier tier) const { return tier == STATUS_HISTORY_DAY ? &minutes : &quarters; }
+
+    StatusSampleRing minutes;
+    StatusSampleRing quarters;
+    StatusHistoryPointsPtr points[STATUS_HISTORY_TIER_COUNT];
+};
+
+#endif // STATUS_HISTORY_H_INCLUDED
@@ -0,0 +1,231 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "statusResource.h"
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+#include <Wt/Http/Request>
+#include <Wt/Http/Response>
+
+#include "config.h"
+#include "misc.h"
+
+static std::string EscapeJson(const std::string & str)
+{
+    std::string escaped;
+    escaped.reserve(str.size());
+
+    for (std::string::const_iterator itr = str.begin(); itr != str.end(); ++itr)
+    {
+        switch (*itr)
+        {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            case '\r':
+                escaped += "\\r";
+                break;
+            case '\t':
+                escaped += "\\t";
+                break;
+            default:
+                if (uint8(*itr) < 0x20)
+                    escaped += Misc::GetFormattedString("\\u%04x", uint8(*itr));
+                else
+                    escaped += *itr;
+                break;
+        }
+    }
+
+    return escaped;
+}
+
+// parses RFC 1123 date (Sun, 06 Nov 1994 08:49:37 GMT) - only format sent in Last-Modified header
+static bool ParseHttpDate(const std::string & str, std::time_t & result)
+{
+    static const char * months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    if (str.size() < 29 || str[3] != ',')
+        return false;
+
+    int day, year, hour, minute, second;
+    if (sscanf(str.c_str() + 5, "%d", &day) != 1 || sscanf(str.c_str() + 12, "%d %d:%d:%d", &year, &hour, &minute, &second) != 4)
+        return false;
+
+    const char * monthPos = strstr(months, str.substr(8, 3).c_str());
+    if (!monthPos || (monthPos - months) % 3)
+        return false;
+
+    int month = (monthPos - months) / 3 + 1;
+
+    // days since epoch for gregorian date, timegm() isn't portable
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64 days = int64(era) * 146097 + dayOfEra - 719468;
+
+    result = std::time_t(days * DAY + hour * HOUR + minute * MINUTE + second);
+    return true;
+}
+
+StatusResource::StatusResource(StatusResourceFormat format, Wt::WObject * parent)
+: Wt::WResource(parent), format(format), lastModifiedTime(0)
+{
+}
+
+StatusResource::~StatusResource()
+{
+    beingDeleted();
+}
+
+void StatusResource::handleRequest(const Wt::Http::Request & request, Wt::Http::Response & response)
+{
+    std::string tmpBody, tmpETag, tmpLastModified;
+    bool notModified;
+
+    {
+        std::lock_guard<std::mutex> lock(bodyMutex);
+
+        UpdateBody();
+
+        tmpETag = eTag;
+        tmpLastModified = lastModified;
+
+        // If-None-Match is more precise so If-Modified-Since is checked only without it
+        if (!request.headerValue("If-None-Match").empty())
+            notModified = request.headerValue("If-None-Match") == eTag;
+        else
+        {
+            // resource isn't modified when it's older or same as client copy
+            std::time_t modifiedSince;
+            notModified = ParseHttpDate(request.headerValue("If-Modified-Since"), modifiedSince) && lastModifiedTime <= modifiedSince;
+        }
+
+        // don't copy body when it won't be sent
+        if (!notModified)
+            tmpBody = body;
+    }
+
+    int maxAge = sConfig.GetConfig(CONFIG_INTERVAL_UPDATE_STATUS);
+
+    response.addHeader("Cache-Control", Misc::GetFormattedString("public, max-age=%i", maxAge > 0 ? maxAge : MINUTE));
+    response.addHeader("ETag", tmpETag);
+    response.addHeader("Last-Modified", tmpLastModified);
+
+    if (notModified)
+    {
+        response.setStatus(304);
+        return;
+    }
+
+    response.setMimeType(format == STATUS_RESOURCE_JSON ? "application/json; charset=utf-8" : "text/plain; charset=utf-8");
+    response.out() << tmpBody;
+}
+
+void StatusResource::UpdateBody()
+{
+    int realmsCount = sConfig.GetConfig(CONFIG_REALMS_COUNT);
+    bool changed = int(statuses.size()) != realmsCount;
+
+    statuses.resize(realmsCount);
+
+    std::time_t updateTime = 0;
+
+    for (int i = 0; i < realmsCount; ++i)
+    {
+        RealmStatusPtr status = sRealmStatusPoller.GetStatus(i);
+
+        if (status != statuses[i])
+        {
+            statuses[i] = status;
+            changed = true;
+        }
+
+        if (status->updateTime > updateTime)
+            updateTime = status->updateTime;
+    }
+
+    if (!changed && !body.empty())
+        return;
+
+    body = format == STATUS_RESOURCE_JSON ? GenerateJson() : GenerateText();
+    eTag = Misc::GetFormattedString("\"%lx\"", (unsigned long)std::hash<std::string>()(body));
+
+    char buffer[64];
+
+    if (!updateTime)
+        updateTime = std::time(NULL);
+
+    // only this resource formats dates, access is serialized by bodyMutex
+    std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&updateTime));
+    lastModified = buffer;
+    lastModifiedTime = updateTime;
+}
+
+std::string StatusResource::GenerateJson()
+{
+    std::string json = "{\"realms\":[";
+
+    for (size_t i = 0; i < statuses.size(); ++i)
+    {
+        const RealmStatus & status = *statuses[i];
+        const RealmInformations & realm = sConfig.GetRealmInformations(i);
+
+        if (i)
+            json += ",";
+
+        // strings are appended directly - they come from status file and config so their length isn't limited
+        json += Misc::GetFormattedString("{\"id\":%i,\"name\":\"", realm.realmId) + EscapeJson(realm.name);
+        json += Misc::GetFormattedString("\",\"online\":%s,\"uptime\":%u,\"players\":%u,\"maxPlayers\":%u,\"queue\":%u,\"maxQueue\":%u,",
+                                         status.IsOnline() ? "true" : "false", status.uptime, status.online, status.maxOnline, status.queue, status.maxQueue);
+        json += "\"revision\":\"" + EscapeJson(status.revision) + "\",\"diff\":\"" + EscapeJson(status.diff) + "\",\"avgDiff\":\"" + EscapeJson(status.avgDiff) + "\",";
+        json += Misc::GetFormattedString("\"alliance\":%u,\"horde\":%u,\"updated\":%lu}", status.ally, status.horde, (unsigned long)status.updateTime);
+    }
+
+    json += "]}";
+
+    return json;
+}
+
+std::string StatusResource::GenerateText()
+{
+    std::string text;
+
+    // same order as in status file, realm name is last because it can contain spaces
+    for (size_t i = 0; i < statuses.size(); ++i)
+    {
+        const RealmStatus & status = *statuses[i];
+        const RealmInformations & realm = sConfig.GetRealmInformations(i);
+
+        text += Misc::GetFormattedString("%i %u %u %u %u %u ", realm.realmId, status.uptime, status.online, status.maxOnline, status.queue, status.maxQueue);
+        text += status.revision + " " + status.diff + " " + status.avgDiff;
+        text += Misc::GetFormattedString(" %u %u ", status.ally, status.horde) + realm.name + "\n";
+    }
+
+    return text;
+}
@@ -0,0 +1,72 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATUS_RESOURCE_H_INCLUDED
+#define STATUS_RESOURCE_H_INCLUDED
+
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Wt/WResource>
+
+#include "realmStatus.h"
+
+enum StatusResourceFormat
+{
+    STATUS_RESOURCE_JSON    = 0,    /**< application/json */
+    STATUS_RESOURCE_TEXT            /**< text/plain, one realm per line */
+};
+
+/********************************************//**
+ * \brief Public realms status served without session.
+ *
+ * Resource is mounted on server (WServer::addResource)
+ * so requests don't create PlayersPanel application.
+ * Body is generated only when some status snapshot
+ * was changed, requests with matching ETag or
+ * If-Modified-Since not older than Last-Modified
+ * get 304 response.
+ *
+ ***********************************************/
+
+class StatusResource : public Wt::WResource
+{
+public:
+    StatusResource(StatusResourceFormat format, Wt::WObject * parent = 0);
+    ~StatusResource();
+
+    void handleRequest(const Wt::Http::Request & request, Wt::Http::Response & response);
+
+private:
+    void UpdateBody();                                  /// regenerates body when snapshots were changed, should be called with locked bodyMutex
+    std::string GenerateJson();
+    std::string GenerateText();
+
+    StatusResourceFormat format;
+
+    std::vector<RealmStatusPtr> statuses;               /// snapshots used to generate body
+    std::string body;
+    std::string eTag;
+    std::string lastModified;                           /// Last-Modified header value
+    std::time_t lastModifiedTime;                       /// time sent in Last-Modified header
+
+    std::mutex bodyMutex;
+};
+
+#endif // STATUS_RESOURCE_H_INCLUDED
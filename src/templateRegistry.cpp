@@ -0,0 +1,233 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "templateRegistry.h"
+
+#include <chrono>
+#include <sys/stat.h>
+
+#include "compiledTemplate.h"
+#include "config.h"
+#include "database.h"
+#include "misc.h"
+
+TemplateRegistry::TemplateRegistry()
+    : templates(new TemplateList()), stopping(false)
+{
+    // first list is loaded before any session can use it
+    Reload();
+
+    worker = std::thread(&TemplateRegistry::Run, this);
+}
+
+TemplateRegistry::~TemplateRegistry()
+{
+    Stop();
+}
+
+TemplateRegistry & TemplateRegistry::Instance()
+{
+    // same as in Config::Instance()
+    if (_registry == nullptr)
+    {
+        _createMutex.lock();
+
+        if (_registry == nullptr)
+            _registry = new TemplateRegistry();
+
+        _createMutex.unlock();
+    }
+
+    return * const_cast<TemplateRegistry*>(_registry);
+}
+
+void TemplateRegistry::Shutdown()
+{
+    std::lock_guard<std::mutex> lock(_createMutex);
+
+    if (_registry != nullptr)
+        const_cast<TemplateRegistry*>(_registry)->Stop();
+}
+
+void TemplateRegistry::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(templatesMutex);
+        stopping = true;
+    }
+
+    stopCondition.notify_all();
+
+    if (worker.joinable())
+        worker.join();
+}
+
+void TemplateRegistry::Run()
+{
+    std::unique_lock<std::mutex> lock(templatesMutex);
+
+    while (!stopping)
+    {
+        int interval = sConfig.GetConfig(CONFIG_INTERVAL_UPDATE_TEMPLATES);
+
+        stopCondition.wait_for(lock, std::chrono::seconds(interval > 0 ? interval : MINUTE));
+
+        if (stopping)
+            break;
+
+        lock.unlock();
+        Reload();
+        lock.lock();
+    }
+}
+
+std::time_t TemplateRegistry::GetModificationTime(const std::string & path)
+{
+    struct stat fileStat;
+
+    if (stat(path.c_str(), &fileStat))
+        return 0;
+
+    return fileStat.st_mtime;
+}
+
+bool TemplateRegistry::LoadTemplateFile(TemplateInfo & tmplt, const TemplateList * current)
+{
+    std::string fullPath = tmplt.GetFullTemplatePath();
+
+    tmplt.modificationTime = GetModificationTime(fullPath);
+
+    if (!tmplt.modificationTime)
+        return false;
+
+    // unchanged file is taken from current list
+    if (current->defaultTemplate.modificationTime == tmplt.modificationTime && current->defaultTemplate.GetFullTemplatePath() == fullPath)
+    {
+        tmplt.currentTemplate = current->defaultTemplate.currentTemplate;
+        tmplt.compiledTemplate = current->defaultTemplate.compiledTemplate;
+
+        // default template is kept even when it couldn't be read
+        return tmplt.currentTemplate != nullptr;
+    }
+
+    for (std::vector<TemplateInfo>::const_iterator itr = current->templates.begin(); itr != current->templates.end(); ++itr)
+    {
+        if (itr->modificationTime == tmplt.modificationTime && itr->GetFullTemplatePath() == fullPath)
+        {
+            tmplt.currentTemplate = itr->currentTemplate;
+            tmplt.compiledTemplate = itr->compiledTemplate;
+            return true;
+        }
+    }
+
+    std::string text = Misc::GetTemplate(fullPath);
+
+    if (text.empty())
+    {
+        tmplt.currentTemplate.reset();
+        tmplt.compiledTemplate.reset();
+        return false;
+    }
+
+    tmplt.currentTemplate = std::make_shared<const std::string>(std::move(text));
+
+    // template is compiled once and shared, when it can't be compiled sessions use WTemplate parsing
+    tmplt.compiledTemplate = TemplateSegmentsPtr(TemplateSegments::Compile(*tmplt.currentTemplate));
+
+    return true;
+}
+
+void TemplateRegistry::Reload()
+{
+    TemplateListPtr current = GetTemplates();
+    TemplateList * list = new TemplateList();
+
+    list->defaultTemplate.name = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_NAME);
+    list->defaultTemplate.stylePath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_STYLE_PATH);
+    list->defaultTemplate.tmpltPath = sConfig.GetConfig(CONFIG_DEFAULT_TEMPLATE_TMPLT_PATH);
+
+    if (!LoadTemplateFile(list->defaultTemplate, current.get()))
+        Misc::Console(DEBUG_CODE, "%s: can't read default template %s\n", __FUNCTION__, list->defaultTemplate.GetFullTemplatePath().c_str());
+
+    Database db;
+
+    if (db.Connect(DB_PANEL_DATA) && db.ExecuteQuery("SELECT name, stylePath, tmpltPath FROM Templates") != DB_RESULT_ERROR)
+    {
+        const std::vector<DatabaseRow> & rows = db.GetRows();
+
+        list->templates.reserve(rows.size());
+
+        for (std::vector<DatabaseRow>::const_iterator itr = rows.begin(); itr != rows.end(); ++itr)
+        {
+            TemplateInfo tmplt;
+            tmplt.name = itr->fields[0].GetString();
+            tmplt.stylePath = itr->fields[1].GetString();
+            tmplt.tmpltPath = itr->fields[2].GetString();
+
+            // template without file or style can't be used
+            if (!tmplt.stylePath.empty() && LoadTemplateFile(tmplt, current.get()))
+                list->templates.push_back(tmplt);
+        }
+    }
+    else // keep templates from db, only files could be changed
+    {
+        for (std::vector<TemplateInfo>::const_iterator itr = current->templates.begin(); itr != current->templates.end(); ++itr)
+        {
+            TemplateInfo tmplt = *itr;
+
+            if (LoadTemplateFile(tmplt, current.get()))
+                list->templates.push_back(tmplt);
+        }
+    }
+
+    // compare with current list - sessions don't need new list when nothing was changed
+    bool changed = list->templates.size() != current->templates.size() || !list->defaultTemplate.IsSame(current->defaultTemplate);
+
+    for (size_t i = 0; !changed && i < list->templates.size(); ++i)
+        changed = !list->templates[i].IsSame(current->templates[i]);
+
+    if (!changed)
+    {
+        delete list;
+        return;
+    }
+
+    Misc::Console(DEBUG_CODE, "%s: templates list changed, %u templates loaded\n", __FUNCTION__, uint32(list->templates.size()));
+
+    std::lock_guard<std::mutex> lock(templatesMutex);
+    templates = TemplateListPtr(list);
+}
+
+TemplateListPtr TemplateRegistry::GetTemplates()
+{
+    std::lock_guard<std::mutex> lock(templatesMutex);
+    return templates;
+}
+
+TemplateInfo TemplateRegistry::GetTemplate(const std::string & name)
+{
+    TemplateListPtr list = GetTemplates();
+
+    for (std::vector<TemplateInfo>::const_iterator itr = list->templates.begin(); itr != list->templates.end(); ++itr)
+        if (itr->name == name)
+            return *itr;
+
+    return list->defaultTemplate;
+}
+
+volatile TemplateRegistry * TemplateRegistry::_registry = nullptr;
+std::mutex TemplateRegistry::_createMutex;
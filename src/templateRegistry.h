@@ -0,0 +1,90 @@
+/*
+*    HG Players Panel - web panel for HellGround server Players
+*    Copyright (C) 2011-2012 HellGround Team : Siof, lukaasm,
+*
+*    This program is free software: you can redistribute it and/or modify
+*    it under the terms of the GNU Affero General Public License version 3 as
+*    published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEMPLATE_REGISTRY_H_INCLUDED
+#define TEMPLATE_REGISTRY_H_INCLUDED
+
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "defines.h"
+
+/********************************************//**
+ * \brief Immutable set of available templates.
+ ***********************************************/
+
+struct TemplateList
+{
+    std::vector<TemplateInfo> templates;                /// templates from Templates table (only with readable .tmplt file)
+    TemplateInfo defaultTemplate;                       /// template from config
+};
+
+typedef std::shared_ptr<const TemplateList> TemplateListPtr;
+
+/********************************************//**
+ * \brief Process wide templates registry.
+ *
+ * Templates are loaded from db and .tmplt files on start
+ * and published as immutable list, so session creation
+ * doesn't need any db query or file read.
+ * Registry thread periodically checks Templates table
+ * and files modification times - new list is published
+ * only when something was changed (unchanged files
+ * aren't read again).
+ *
+ ***********************************************/
+
+class TemplateRegistry
+{
+public:
+    static TemplateRegistry & Instance();
+    static void Shutdown();                             /// stops registry thread (if registry was created)
+
+    TemplateListPtr GetTemplates();                     /// returns current templates list, never NULL
+    TemplateInfo GetTemplate(const std::string & name); /// returns template with given name or default one when it doesn't exist
+
+private:
+    TemplateRegistry();
+    TemplateRegistry(const TemplateRegistry &) {}
+    ~TemplateRegistry();
+
+    void Run();                                         /// registry thread loop
+    void Stop();
+    void Reload();                                      /// publishes new list when templates were changed
+
+    static bool LoadTemplateFile(TemplateInfo & tmplt, const TemplateList * current); /// fills template text (reuses text from current list when file wasn't changed)
+    static std::time_t GetModificationTime(const std::string & path);
+
+    TemplateListPtr templates;
+    bool stopping;
+
+    std::thread worker;
+    std::mutex templatesMutex;
+    std::condition_variable stopCondition;
+
+    static volatile TemplateRegistry * _registry;
+    static std::mutex _createMutex;
+};
+
+#define sTemplateRegistry TemplateRegistry::Instance()
+
+#endif // TEMPLATE_REGISTRY_H_INCLUDED